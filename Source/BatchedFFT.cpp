@@ -0,0 +1,355 @@
+#include "BatchedFFT.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if JUCE_INTEL
+ #include <xmmintrin.h>
+#elif JUCE_ARM && (defined (__aarch64__) || defined (_M_ARM64))
+ #include <arm_neon.h>
+ #define MONOLITH_BATCHEDFFT_NEON 1
+#endif
+
+namespace
+{
+    //==============================================================================
+    // The few 4-lane operations the batch needs. A plain array fallback keeps
+    // other targets building; it computes the same thing a lane at a time.
+   #if JUCE_INTEL
+    using Vector = __m128;
+    using Mask = __m128;
+    inline Vector load(const float* p)                     { return _mm_load_ps(p); }
+    inline Vector loadUnaligned(const float* p)            { return _mm_loadu_ps(p); }
+    inline void store(float* p, Vector v)                  { _mm_store_ps(p, v); }
+    inline Vector broadcast(float x)                       { return _mm_set1_ps(x); }
+    inline Vector add(Vector a, Vector b)                  { return _mm_add_ps(a, b); }
+    inline Vector sub(Vector a, Vector b)                  { return _mm_sub_ps(a, b); }
+    inline Vector mul(Vector a, Vector b)                  { return _mm_mul_ps(a, b); }
+    inline Vector squareRoot(Vector v)                     { return _mm_sqrt_ps(v); }
+    inline Mask greaterThan(Vector a, Vector b)            { return _mm_cmpgt_ps(a, b); }
+    inline Mask atLeast(Vector a, Vector b)                { return _mm_cmpge_ps(a, b); }
+    inline Mask atMost(Vector a, Vector b)                 { return _mm_cmple_ps(a, b); }
+    inline Mask both(Mask a, Mask b)                       { return _mm_and_ps(a, b); }
+    inline Vector select(Mask m, Vector a, Vector b)       { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+
+    /** Rows of four samples become columns: afterwards v[j] holds element j of every input row. */
+    inline void transpose(Vector& v0, Vector& v1, Vector& v2, Vector& v3) { _MM_TRANSPOSE4_PS(v0, v1, v2, v3); }
+   #elif MONOLITH_BATCHEDFFT_NEON
+    using Vector = float32x4_t;
+    using Mask = uint32x4_t;
+    inline Vector load(const float* p)                     { return vld1q_f32(p); }
+    inline Vector loadUnaligned(const float* p)            { return vld1q_f32(p); }
+    inline void store(float* p, Vector v)                  { vst1q_f32(p, v); }
+    inline Vector broadcast(float x)                       { return vdupq_n_f32(x); }
+    inline Vector add(Vector a, Vector b)                  { return vaddq_f32(a, b); }
+    inline Vector sub(Vector a, Vector b)                  { return vsubq_f32(a, b); }
+    inline Vector mul(Vector a, Vector b)                  { return vmulq_f32(a, b); }
+    inline Vector squareRoot(Vector v)                     { return vsqrtq_f32(v); }
+    inline Mask greaterThan(Vector a, Vector b)            { return vcgtq_f32(a, b); }
+    inline Mask atLeast(Vector a, Vector b)                { return vcgeq_f32(a, b); }
+    inline Mask atMost(Vector a, Vector b)                 { return vcleq_f32(a, b); }
+    inline Mask both(Mask a, Mask b)                       { return vandq_u32(a, b); }
+    inline Vector select(Mask m, Vector a, Vector b)       { return vbslq_f32(m, a, b); }
+
+    /** Rows of four samples become columns: afterwards v[j] holds element j of every input row. */
+    inline void transpose(Vector& v0, Vector& v1, Vector& v2, Vector& v3)
+    {
+        const auto t01 = vtrnq_f32(v0, v1);
+        const auto t23 = vtrnq_f32(v2, v3);
+        v0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+        v1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+        v2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+        v3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+    }
+   #else
+    struct Vector { float lane[4]; };
+    struct Mask { bool lane[4]; };
+    inline Vector load(const float* p)                     { Vector v; std::memcpy(v.lane, p, sizeof(v.lane)); return v; }
+    inline Vector loadUnaligned(const float* p)            { return load(p); }
+    inline void store(float* p, Vector v)                  { std::memcpy(p, v.lane, sizeof(v.lane)); }
+    inline Vector broadcast(float x)                       { return { { x, x, x, x } }; }
+    inline Vector add(Vector a, Vector b)                  { for (int i = 0; i < 4; ++i) a.lane[i] += b.lane[i]; return a; }
+    inline Vector sub(Vector a, Vector b)                  { for (int i = 0; i < 4; ++i) a.lane[i] -= b.lane[i]; return a; }
+    inline Vector mul(Vector a, Vector b)                  { for (int i = 0; i < 4; ++i) a.lane[i] *= b.lane[i]; return a; }
+    inline Vector squareRoot(Vector v)                     { for (int i = 0; i < 4; ++i) v.lane[i] = std::sqrt(v.lane[i]); return v; }
+    inline Mask greaterThan(Vector a, Vector b)            { Mask m; for (int i = 0; i < 4; ++i) m.lane[i] = a.lane[i] > b.lane[i]; return m; }
+    inline Mask atLeast(Vector a, Vector b)                { Mask m; for (int i = 0; i < 4; ++i) m.lane[i] = a.lane[i] >= b.lane[i]; return m; }
+    inline Mask atMost(Vector a, Vector b)                 { Mask m; for (int i = 0; i < 4; ++i) m.lane[i] = a.lane[i] <= b.lane[i]; return m; }
+    inline Mask both(Mask a, Mask b)                       { for (int i = 0; i < 4; ++i) a.lane[i] = a.lane[i] && b.lane[i]; return a; }
+    inline Vector select(Mask m, Vector a, Vector b)       { for (int i = 0; i < 4; ++i) a.lane[i] = m.lane[i] ? a.lane[i] : b.lane[i]; return a; }
+
+    /** Rows of four samples become columns: afterwards v[j] holds element j of every input row. */
+    inline void transpose(Vector& v0, Vector& v1, Vector& v2, Vector& v3)
+    {
+        const Vector rows[4] { v0, v1, v2, v3 };
+        Vector* columns[4] { &v0, &v1, &v2, &v3 };
+
+        for (int column = 0; column < 4; ++column)
+            for (int row = 0; row < 4; ++row)
+                columns[column]->lane[row] = rows[row].lane[column];
+    }
+   #endif
+
+    constexpr int vectorLanes = 4;
+
+    /**
+     * Gets twice the magnitude of bin k of a real frame from its packed half-size
+     * transform. With Z[k] = a + ib and Z[M - k] = c + id, the even and odd samples'
+     * spectra are E = ((a + c) + i(b - d)) / 2 and O = ((b + d) + i(c - a)) / 2,
+     * and X[k] = E + W O for W = exp(-2πik / N). The halving is left to the caller.
+     */
+    inline Vector getDoubledMagnitude(Vector a, Vector b, Vector c, Vector d, Vector wr, Vector wi)
+    {
+        const auto evenReal = add(a, c);
+        const auto evenImag = sub(b, d);
+        const auto oddReal = add(b, d);
+        const auto oddImag = sub(c, a);
+
+        const auto real = add(evenReal, sub(mul(wr, oddReal), mul(wi, oddImag)));
+        const auto imag = add(evenImag, add(mul(wr, oddImag), mul(wi, oddReal)));
+        return squareRoot(add(mul(real, real), mul(imag, imag)));
+    }
+}
+
+//==============================================================================
+void BatchedFFT::prepare(int fftOrder, SharedAnalysisTables::WindowType windowType, double sampleRate, int numChannels)
+{
+    arena_.release();
+    real_ = nullptr;
+    imag_ = nullptr;
+    bitReversed_ = nullptr;
+    silence_ = nullptr;
+    numChannels_ = 0;
+    numLanes_ = 0;
+
+    if (numChannels <= 0)
+    {
+        tables_.reset();
+        return;
+    }
+
+    jassert(numChannels <= maxLanes);
+    numChannels_ = juce::jmin(numChannels, maxLanes);
+
+    tables_ = SharedAnalysisTables::acquire(fftOrder, windowType, sampleRate);
+    window_ = tables_->getWindow();
+    twiddles_ = tables_->getTwiddles();
+    fftSize_ = tables_->getFFTSize();
+
+    const int numPoints = fftSize_ / 2;
+    const int numLanes = numChannels_ <= 4 ? 4 : numChannels_ <= 8 ? 8 : maxLanes;
+
+    const auto realOffset = arena_.reserve<float>(static_cast<size_t>(numPoints * numLanes));
+    const auto imagOffset = arena_.reserve<float>(static_cast<size_t>(numPoints * numLanes));
+    const auto bitReversedOffset = arena_.reserve<int>(static_cast<size_t>(numPoints));
+    const auto silenceOffset = arena_.reserve<float>(static_cast<size_t>(fftSize_));
+
+    if (!arena_.allocate(false))
+    {
+        numChannels_ = 0;
+        return;
+    }
+
+    real_ = arena_.get<float>(realOffset);
+    imag_ = arena_.get<float>(imagOffset);
+    bitReversed_ = arena_.get<int>(bitReversedOffset);
+    silence_ = arena_.get<float>(silenceOffset);
+    numLanes_ = numLanes;
+
+    const int numBits = fftOrder - 1;
+    for (int point = 0; point < numPoints; ++point)
+    {
+        int reversed = 0;
+        for (int bit = 0; bit < numBits; ++bit)
+            reversed |= ((point >> bit) & 1) << (numBits - 1 - bit);
+
+        bitReversed_[point] = reversed;
+    }
+
+    // Channels search every bin until told otherwise; padding lanes search none
+    for (int lane = 0; lane < maxLanes; ++lane)
+        setSearchRange(lane, lane < numChannels_ ? 0 : numPoints, lane < numChannels_ ? numPoints - 1 : -1);
+}
+
+void BatchedFFT::setSearchRange(int lane, int lowestBin, int highestBin)
+{
+    lowestBins_[static_cast<size_t>(lane)] = static_cast<float>(lowestBin);
+    highestBins_[static_cast<size_t>(lane)] = static_cast<float>(highestBin);
+}
+
+void BatchedFFT::perform(const float* const* frames)
+{
+    if (numLanes_ == 0)
+        return;
+
+    windowFrames(frames);
+    transform();
+    computeMagnitudes();
+    findStrongestBins();
+}
+
+//==============================================================================
+void BatchedFFT::windowFrames(const float* const* frames)
+{
+    for (int group = 0; group < numLanes_; group += vectorLanes)
+    {
+        std::array<const float*, vectorLanes> source;
+
+        for (int i = 0; i < vectorLanes; ++i)
+        {
+            const int lane = group + i;
+            source[static_cast<size_t>(i)] = lane < numChannels_ && frames[lane] != nullptr ? frames[lane] : silence_;
+        }
+
+        // Four samples of four frames at a time, turned into four samples of every lane
+        for (int sample = 0; sample < fftSize_; sample += vectorLanes)
+        {
+            auto s0 = loadUnaligned(source[0] + sample);
+            auto s1 = loadUnaligned(source[1] + sample);
+            auto s2 = loadUnaligned(source[2] + sample);
+            auto s3 = loadUnaligned(source[3] + sample);
+            transpose(s0, s1, s2, s3);
+
+            // Even samples are the real parts of the half-size transform's inputs, odd ones the imaginary
+            const int first = bitReversed_[sample / 2] * numLanes_ + group;
+            const int second = bitReversed_[sample / 2 + 1] * numLanes_ + group;
+
+            store(real_ + first, mul(s0, broadcast(window_[sample])));
+            store(imag_ + first, mul(s1, broadcast(window_[sample + 1])));
+            store(real_ + second, mul(s2, broadcast(window_[sample + 2])));
+            store(imag_ + second, mul(s3, broadcast(window_[sample + 3])));
+        }
+    }
+}
+
+void BatchedFFT::transform()
+{
+    const int numPoints = fftSize_ / 2;
+
+    // Size-2 butterflies need no twiddles
+    for (int point = 0; point < numPoints; point += 2)
+    {
+        float* upperReal = real_ + point * numLanes_;
+        float* upperImag = imag_ + point * numLanes_;
+        float* lowerReal = upperReal + numLanes_;
+        float* lowerImag = upperImag + numLanes_;
+
+        for (int lane = 0; lane < numLanes_; lane += vectorLanes)
+        {
+            const auto ar = load(upperReal + lane);
+            const auto ai = load(upperImag + lane);
+            const auto br = load(lowerReal + lane);
+            const auto bi = load(lowerImag + lane);
+
+            store(upperReal + lane, add(ar, br));
+            store(upperImag + lane, add(ai, bi));
+            store(lowerReal + lane, sub(ar, br));
+            store(lowerImag + lane, sub(ai, bi));
+        }
+    }
+
+    for (int size = 4; size <= numPoints; size *= 2)
+    {
+        const int half = size / 2;
+        const int twiddleStep = fftSize_ / size;  // exp(-2πij / size) = exp(-2πi (j * twiddleStep) / fftSize_)
+
+        for (int start = 0; start < numPoints; start += size)
+        {
+            for (int j = 0; j < half; ++j)
+            {
+                const auto twiddle = twiddles_[j * twiddleStep];
+                const auto wr = broadcast(twiddle.real());
+                const auto wi = broadcast(twiddle.imag());
+
+                float* upperReal = real_ + (start + j) * numLanes_;
+                float* upperImag = imag_ + (start + j) * numLanes_;
+                float* lowerReal = upperReal + half * numLanes_;
+                float* lowerImag = upperImag + half * numLanes_;
+
+                for (int lane = 0; lane < numLanes_; lane += vectorLanes)
+                {
+                    const auto ar = load(upperReal + lane);
+                    const auto ai = load(upperImag + lane);
+                    const auto br = load(lowerReal + lane);
+                    const auto bi = load(lowerImag + lane);
+
+                    // b * W
+                    const auto tr = sub(mul(br, wr), mul(bi, wi));
+                    const auto ti = add(mul(br, wi), mul(bi, wr));
+
+                    store(upperReal + lane, add(ar, tr));
+                    store(upperImag + lane, add(ai, ti));
+                    store(lowerReal + lane, sub(ar, tr));
+                    store(lowerImag + lane, sub(ai, ti));
+                }
+            }
+        }
+    }
+}
+
+void BatchedFFT::computeMagnitudes()
+{
+    //==============================================================================
+    // Bin k needs Z[k] and Z[M - k], and so does bin M - k, so the pair is computed
+    // together and the magnitudes can overwrite the real parts in place.
+    //==============================================================================
+    const int numPoints = fftSize_ / 2;
+    const auto scale = broadcast(0.5f / static_cast<float>(fftSize_));
+
+    for (int k = 0; k <= numPoints / 2; ++k)
+    {
+        const int mirror = (numPoints - k) & (numPoints - 1);
+        const auto twiddle = twiddles_[k];
+        const auto mirrorTwiddle = twiddles_[mirror];
+        const auto wr = broadcast(twiddle.real());
+        const auto wi = broadcast(twiddle.imag());
+        const auto mirrorWr = broadcast(mirrorTwiddle.real());
+        const auto mirrorWi = broadcast(mirrorTwiddle.imag());
+
+        float* binReal = real_ + k * numLanes_;
+        const float* binImag = imag_ + k * numLanes_;
+        float* mirrorReal = real_ + mirror * numLanes_;
+        const float* mirrorImag = imag_ + mirror * numLanes_;
+
+        for (int lane = 0; lane < numLanes_; lane += vectorLanes)
+        {
+            const auto a = load(binReal + lane);
+            const auto b = load(binImag + lane);
+            const auto c = load(mirrorReal + lane);
+            const auto d = load(mirrorImag + lane);
+
+            store(binReal + lane, mul(getDoubledMagnitude(a, b, c, d, wr, wi), scale));
+
+            if (mirror != k)
+                store(mirrorReal + lane, mul(getDoubledMagnitude(c, d, a, b, mirrorWr, mirrorWi), scale));
+        }
+    }
+}
+
+void BatchedFFT::findStrongestBins()
+{
+    // Only the bins some channel searches (padding lanes have empty ranges)
+    const auto firstBin = static_cast<int>(*std::min_element(lowestBins_.begin(), lowestBins_.begin() + numChannels_));
+    const auto lastBin = static_cast<int>(*std::max_element(highestBins_.begin(), highestBins_.begin() + numChannels_));
+
+    for (int group = 0; group < numLanes_; group += vectorLanes)
+    {
+        const auto lowest = load(lowestBins_.data() + group);
+        const auto highest = load(highestBins_.data() + group);
+        auto strongest = broadcast(-1.0f);
+        auto strongestBin = lowest;
+
+        for (int k = firstBin; k <= lastBin; ++k)
+        {
+            const auto bin = broadcast(static_cast<float>(k));
+            const auto magnitude = load(real_ + k * numLanes_ + group);
+            const auto stronger = both(greaterThan(magnitude, strongest), both(atLeast(bin, lowest), atMost(bin, highest)));
+
+            strongest = select(stronger, magnitude, strongest);
+            strongestBin = select(stronger, bin, strongestBin);
+        }
+
+        store(strongestMagnitudes_.data() + group, strongest);
+        store(strongestBins_.data() + group, strongestBin);
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "DetectorArena.h"
+#include "SharedAnalysisTables.h"
+#include <array>
+#include <complex>
+#include <memory>
+
+//==============================================================================
+/**
+ * Magnitude spectra of several equally sized frames, computed in lockstep.
+ *
+ * Frames are analysed as lanes of 4-wide SIMD registers rather than one
+ * transform after the other: every buffer holds a point of every lane side by
+ * side (structure of arrays across channels), so each windowing step,
+ * butterfly, magnitude and argmax comparison runs for four lanes at once.
+ * Channels are rounded up to 4, 8 or 16 lanes; the spare lanes analyse silence.
+ *
+ * Each real frame is transformed as a half-size complex FFT of its even and
+ * odd samples, split into the real spectrum afterwards. Magnitudes match
+ * PitchDetector's (|X[k]| / fftSize), as does the strongest-bin search.
+ */
+class BatchedFFT
+{
+public:
+    //==============================================================================
+    static constexpr int maxLanes = 16;       ///< Channels one engine can analyse together
+
+    BatchedFFT() = default;
+    ~BatchedFFT() = default;
+
+    /**
+     * Acquires the shared tables and lays out the working memory. Not real-time safe.
+     *
+     * @param fftOrder    log2 of the frame size
+     * @param windowType  Window applied to every frame
+     * @param sampleRate  Audio sample rate in Hz (selects the shared tables)
+     * @param numChannels Frames per batch (up to maxLanes; 0 releases the memory)
+     */
+    void prepare(int fftOrder, SharedAnalysisTables::WindowType windowType, double sampleRate, int numChannels);
+
+    /** Gets the number of lanes each buffer interleaves (4, 8 or 16; 0 before prepare()). */
+    int getNumLanes() const { return numLanes_; }
+
+    /**
+     * Sets the bins a lane's strongest bin is searched in.
+     *
+     * @param lane       Lane index
+     * @param lowestBin  First bin searched
+     * @param highestBin Last bin searched
+     */
+    void setSearchRange(int lane, int lowestBin, int highestBin);
+
+    /**
+     * Windows and transforms one frame per lane, then computes the magnitudes
+     * and each lane's strongest bin (audio thread).
+     *
+     * @param frames One frame of fftSize samples per channel; nullptr analyses silence
+     */
+    void perform(const float* const* frames);
+
+    /** Gets the magnitudes from the last perform(): bin k of lane l is at [k * getNumLanes() + l]. */
+    const float* getMagnitudes() const { return real_; }
+
+    /** Gets a lane's strongest bin within its search range from the last perform(). */
+    int getStrongestBin(int lane) const { return static_cast<int>(strongestBins_[static_cast<size_t>(lane)]); }
+
+    /** Gets the magnitude of a lane's strongest bin (-1 if its search range is empty). */
+    float getStrongestMagnitude(int lane) const { return strongestMagnitudes_[static_cast<size_t>(lane)]; }
+
+private:
+    //==============================================================================
+    using Lanes = std::array<float, maxLanes>;
+
+    /** Windows the frames into the bit-reversed half-size transform inputs. */
+    void windowFrames(const float* const* frames);
+
+    /** Runs the radix-2 butterfly passes of the half-size transforms in place. */
+    void transform();
+
+    /** Splits the half-size spectra into the frames' magnitudes, left in real_. */
+    void computeMagnitudes();
+
+    /** Finds every lane's strongest bin within its search range. */
+    void findStrongestBins();
+
+    std::shared_ptr<const SharedAnalysisTables> tables_;      ///< Window and twiddles, shared with the detectors
+    const float* window_ = nullptr;                           ///< Window coefficients (owned by tables_)
+    const std::complex<float>* twiddles_ = nullptr;           ///< exp(-2πik / fftSize_) for k < fftSize_ / 2 (owned by tables_)
+    int fftSize_ = 0;                                         ///< Frame size
+    int numChannels_ = 0;                                     ///< Frames passed to each perform()
+    int numLanes_ = 0;                                        ///< Lanes per point (numChannels_ rounded up)
+
+    // Working memory (every pointer below points into arena_, laid out in prepare())
+    DetectorArena arena_;                                     ///< Single aligned block for all buffers
+    float* real_ = nullptr;                                   ///< Real parts, fftSize_ / 2 points of numLanes_; magnitudes after perform()
+    float* imag_ = nullptr;                                   ///< Imaginary parts, fftSize_ / 2 points of numLanes_
+    int* bitReversed_ = nullptr;                              ///< Bit-reversed order of the fftSize_ / 2 points
+    const float* silence_ = nullptr;                          ///< fftSize_ zeros, for lanes without a frame
+
+    alignas(16) Lanes lowestBins_ {};                         ///< Per-lane search range
+    alignas(16) Lanes highestBins_ {};
+    alignas(16) Lanes strongestBins_ {};                      ///< Per-lane argmax from the last perform()
+    alignas(16) Lanes strongestMagnitudes_ {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BatchedFFT)
+};
@@ -0,0 +1,225 @@
+#include "BeatTracker.h"
+#include <cmath>
+
+//==============================================================================
+void BeatTracker::prepare(double sampleRate)
+{
+    sampleRate_ = sampleRate > 0.0 ? sampleRate : 44100.0;
+    hopSamples_ = juce::jmax(1, juce::roundToInt(sampleRate_ * hopSeconds_));
+
+    const double actualHopSeconds = hopSamples_ / sampleRate_;
+    acfDecay_ = std::exp(-actualHopSeconds / 8.0);
+    meanDecay_ = std::exp(-actualHopSeconds / 1.0);
+    energyDecay_ = std::exp(-actualHopSeconds / 2.0);
+
+    // Log-normal preference centred on 120 BPM, one octave wide
+    for (int lag = minLag_; lag <= maxLag_; ++lag)
+    {
+        const double bpm = 60.0 / (lag * actualHopSeconds);
+        const double octaves = std::log2(bpm / 120.0);
+        tempoPrior_[static_cast<size_t>(lag)] = (float) std::exp(-0.5 * octaves * octaves);
+    }
+
+    reset();
+}
+
+void BeatTracker::reset()
+{
+    hopEnergy_ = 0.0;
+    hopFill_ = 0;
+    previousLogEnergy_ = 0.0f;
+    onsetMean_ = 0.0f;
+    onsetEnergy_ = 0.0;
+    hopIndex_ = 0;
+
+    onsetRing_.fill(0.0f);
+    autocorrelation_.fill(0.0);
+    onsetPower_ = 0.0;
+    period_ = (float) (60.0 / (120.0 * hopSamples_ / sampleRate_));
+    tempoStrength_ = 0.0f;
+    updateTransitionWeights();
+
+    scoreRing_.fill(0.0f);
+    hopsSinceBeat_ = 0;
+    hopsToNextBeat_ = -1;
+    predictedThisBeat_ = false;
+    beatCount_ = 0;
+    unsupportedBeats_ = 0;
+    lastBeatSample_ = 0;
+
+    publishedBpm_.store(0.0, std::memory_order_relaxed);
+}
+
+//==============================================================================
+void BeatTracker::processBlock(const float* audioData, int numSamples, juce::int64 blockStartSample)
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        hopEnergy_ += (double) audioData[i] * audioData[i];
+
+        if (++hopFill_ == hopSamples_)
+        {
+            processHop(hopEnergy_ / hopSamples_, blockStartSample + i + 1);
+            hopEnergy_ = 0.0;
+            hopFill_ = 0;
+        }
+    }
+}
+
+void BeatTracker::processHop(double meanSquare, juce::int64 hopEndSample)
+{
+    // Onset strength: rise in log energy, floored at -80 dB so noise doesn't count
+    const auto logEnergy = (float) std::log(meanSquare + 1.0e-8);
+    const float onset = juce::jmax(0.0f, logEnergy - previousLogEnergy_);
+    previousLogEnergy_ = logEnergy;
+
+    onsetMean_ = (float) (onsetMean_ * meanDecay_ + onset * (1.0 - meanDecay_));
+    onsetEnergy_ = onsetEnergy_ * energyDecay_ + (double) onset * onset * (1.0 - energyDecay_);
+    const float centredOnset = onset - onsetMean_;
+
+    // Tempo: one multiply-add per lag keeps the windowed autocorrelation current
+    const auto hop = hopIndex_++;
+    onsetRing_[static_cast<size_t>(hop & ringMask_)] = centredOnset;
+    onsetPower_ = onsetPower_ * acfDecay_ + (double) centredOnset * centredOnset;
+
+    // From a hop below the shortest period: the comb's teeth read a lag either side
+    for (int lag = minLag_ - 1; lag < numAcfLags_; ++lag)
+        autocorrelation_[static_cast<size_t>(lag)] = autocorrelation_[static_cast<size_t>(lag)] * acfDecay_
+            + (double) centredOnset * onsetRing_[static_cast<size_t>((hop - lag) & ringMask_)];
+
+    updateTempo();
+
+    // Beat phase: best predecessor between half and twice a period back
+    float bestPast = 0.0f;
+    for (int gap = juce::roundToInt(period_ * 0.5f); gap <= juce::roundToInt(period_ * 2.0f); ++gap)
+        bestPast = juce::jmax(bestPast, transitionWeights_[static_cast<size_t>(gap)] * getPastScore(hop - gap));
+
+    scoreRing_[static_cast<size_t>(hop & ringMask_)] = (1.0f - scoreMix_) * onset + scoreMix_ * bestPast;
+
+    ++hopsSinceBeat_;
+
+    if (!predictedThisBeat_ && hopsSinceBeat_ >= juce::roundToInt(period_ * 0.5f))
+    {
+        predictNextBeat();
+        predictedThisBeat_ = true;
+    }
+
+    // A beat is supported by an onset clearly above the running mean within a few hops either side.
+    // After several unsupported ones in a row the beats are only extrapolated, so start counting again
+    if (beatCount_ > 0 && hopsSinceBeat_ == beatSupportHops_)
+    {
+        bool isSupported = false;
+        for (int back = 0; back <= 2 * beatSupportHops_; ++back)
+            isSupported = isSupported || onsetRing_[static_cast<size_t>((hop - back) & ringMask_)] > onsetMean_;
+
+        unsupportedBeats_ = isSupported ? 0 : unsupportedBeats_ + 1;
+        if (unsupportedBeats_ >= maxUnsupportedBeats_)
+            beatCount_ = 0;
+    }
+
+    if (hopsToNextBeat_ > 0 && --hopsToNextBeat_ == 0)
+    {
+        ++beatCount_;
+        lastBeatSample_ = hopEndSample;
+        hopsSinceBeat_ = 0;
+        hopsToNextBeat_ = -1;
+        predictedThisBeat_ = false;
+    }
+
+    publishedBpm_.store(isLocked() ? 60.0 * sampleRate_ / (period_ * hopSamples_) : 0.0, std::memory_order_relaxed);
+}
+
+void BeatTracker::updateTempo()
+{
+    if (onsetPower_ <= 0.0)
+        return;
+
+    // Each lag plus its double (a two-tooth comb), weighted by the tempo preference.
+    // Teeth span a hop either side: a period between whole hops splits its peak across neighbours.
+    const auto getTooth = [this](int lag)
+    {
+        return autocorrelation_[static_cast<size_t>(lag - 1)] + autocorrelation_[static_cast<size_t>(lag)]
+               + autocorrelation_[static_cast<size_t>(juce::jmin(lag + 1, numAcfLags_ - 1))];
+    };
+
+    const auto getScore = [this, &getTooth](int lag)
+    {
+        return (double) tempoPrior_[static_cast<size_t>(lag)] * (getTooth(lag) + 0.5 * getTooth(2 * lag));
+    };
+
+    int bestLag = minLag_;
+    for (int lag = minLag_ + 1; lag <= maxLag_; ++lag)
+        if (getScore(lag) > getScore(bestLag))
+            bestLag = lag;
+
+    tempoStrength_ = (float) (autocorrelation_[static_cast<size_t>(bestLag)] / onsetPower_);
+
+    // Parabolic interpolation for a fractional period
+    float period = (float) bestLag;
+    if (bestLag > minLag_ && bestLag < maxLag_)
+    {
+        const double previous = getScore(bestLag - 1), peak = getScore(bestLag), next = getScore(bestLag + 1);
+        const double curvature = previous - 2.0 * peak + next;
+
+        if (curvature < 0.0)
+            period += (float) (0.5 * (previous - next) / curvature);
+    }
+
+    if (std::abs(period - period_) > 0.05f)
+    {
+        period_ = period;
+        updateTransitionWeights();
+    }
+}
+
+void BeatTracker::updateTransitionWeights()
+{
+    // Log-Gaussian in the ratio of the gap to the period
+    transitionWeights_[0] = 0.0f;
+
+    for (size_t gap = 1; gap < transitionWeights_.size(); ++gap)
+    {
+        const float deviation = transitionTightness_ * std::log((float) gap / period_);
+        transitionWeights_[gap] = std::exp(-0.5f * deviation * deviation);
+    }
+}
+
+void BeatTracker::predictNextBeat()
+{
+    // The hop in the last period with the best cumulative score is where the
+    // programme puts the latest beat: on-beat hops carry their own onset on top
+    // of the chain of earlier beats. The next beat is one period after it.
+    const auto now = hopIndex_ - 1;
+    const int window = juce::jmin(maxLag_, juce::roundToInt(period_));
+
+    auto lastBeatHop = now;
+    for (int back = 1; back < window; ++back)
+        if (getPastScore(now - back) > getPastScore(lastBeatHop))
+            lastBeatHop = now - back;
+
+    hopsToNextBeat_ = juce::jmax(1, juce::roundToInt((float) (lastBeatHop - now) + period_));
+}
+
+//==============================================================================
+bool BeatTracker::isLocked() const
+{
+    return beatCount_ >= 4 && tempoStrength_ >= 0.1f && onsetEnergy_ >= minOnsetEnergy_;
+}
+
+BeatTracker::Position BeatTracker::getPosition(juce::int64 streamSample) const
+{
+    Position result;
+    if (!isLocked())
+        return result;
+
+    // One quarter note per beat, counted from the first beat; extrapolated at the current period
+    const double periodSamples = (double) period_ * hopSamples_;
+    const double beat = (double) (beatCount_ - 1) + (double) (streamSample - lastBeatSample_) / periodSamples;
+
+    result.isValid = true;
+    result.ppq = juce::jmax(0.0, beat);
+    result.seconds = (double) streamSample / sampleRate_;
+    result.bpm = 60.0 * sampleRate_ / periodSamples;
+    result.bar = (int) std::floor(result.ppq / 4.0);
+    return result;
+}
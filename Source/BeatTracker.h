@@ -0,0 +1,138 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "HostTimeline.h"
+#include <array>
+#include <atomic>
+
+//==============================================================================
+/**
+ * Follows the tempo and beat of the input when there is no host transport.
+ *
+ * The input is cut into ~11.6 ms hops and each hop's rise in log energy is
+ * its onset strength. Tempo comes from an exponentially windowed
+ * autocorrelation of that envelope, updated one hop at a time (one
+ * multiply-add per lag), with each lag also credited with its double (a
+ * two-tooth comb) and weighted by a log-normal preference around 120 BPM.
+ *
+ * Beat phase comes from an online dynamic programme: each hop's cumulative
+ * score is its onset strength plus the best earlier score one period back,
+ * weighted by how far that gap is from the period. Halfway between beats the
+ * score is extrapolated one period ahead and the next beat is placed at its
+ * peak, so beats are reported as they happen rather than after the fact.
+ * The tracker only stays locked while onsets keep arriving: when the recent
+ * onset energy falls below a floor, or several predicted beats in a row pass
+ * without an onset near them, it lets go and counts beats afresh.
+ *
+ * All state lives in fixed arrays; processBlock() runs on the audio thread
+ * with a bounded cost per hop. Once locked, getPosition() maps stream
+ * positions to a beat timeline (one quarter note per beat, bars of four) in
+ * the same form as HostTimeline, so recordings made without a transport can
+ * still be quantized and exported in musical time.
+ */
+class BeatTracker
+{
+public:
+    //==============================================================================
+    using Position = HostTimeline::Position;
+
+    BeatTracker() = default;
+
+    /**
+     * Prepares the tracker and forgets all history.
+     *
+     * @param sampleRate Audio sample rate in Hz
+     */
+    void prepare(double sampleRate);
+
+    /** Forgets the tempo, beats and onset history. */
+    void reset();
+
+    /**
+     * Analyses a block of input (audio thread).
+     *
+     * @param audioData Mono samples
+     * @param numSamples Number of samples
+     * @param blockStartSample Stream position of the first sample
+     */
+    void processBlock(const float* audioData, int numSamples, juce::int64 blockStartSample);
+
+    /**
+     * Converts a stream position to the tracked beat timeline (audio thread).
+     * Invalid until the tracker has locked on to a tempo.
+     */
+    Position getPosition(juce::int64 streamSample) const;
+
+    /** Checks if a tempo and beat phase have been found (audio thread). */
+    bool isLocked() const;
+
+    /** Gets the tracked tempo, or 0 if not locked. Lock-free; any thread. */
+    double getTempo() const { return publishedBpm_.load(std::memory_order_relaxed); }
+
+private:
+    //==============================================================================
+    /** Processes one complete hop. */
+    void processHop(double meanSquare, juce::int64 hopEndSample);
+
+    /** Picks the beat period from the autocorrelation. */
+    void updateTempo();
+
+    /** Recomputes the transition weights after the period changed. */
+    void updateTransitionWeights();
+
+    /** Schedules the next beat one period after the best-scoring recent hop. */
+    void predictNextBeat();
+
+    /** Gets the cumulative score of a past hop. */
+    float getPastScore(juce::int64 hop) const { return scoreRing_[static_cast<size_t>(hop & ringMask_)]; }
+
+    static constexpr double hopSeconds_ = 0.0116;             ///< Onset envelope resolution
+    static constexpr double minBpm_ = 60.0;                   ///< Slowest tempo considered
+    static constexpr double maxBpm_ = 200.0;                  ///< Fastest tempo considered
+    static constexpr int maxLag_ = 87;                        ///< Longest period in hops (minBpm_)
+    static constexpr int minLag_ = 26;                        ///< Shortest period in hops (maxBpm_)
+    static constexpr int numAcfLags_ = 2 * maxLag_ + 1;       ///< Lags kept, for the comb's second tooth
+    static constexpr int ringSize_ = 512;                     ///< History in hops (power of two, > 2 * maxLag_)
+    static constexpr juce::int64 ringMask_ = ringSize_ - 1;
+    static constexpr float scoreMix_ = 0.9f;                  ///< Share of the cumulative score taken from the past
+    static constexpr float transitionTightness_ = 5.0f;       ///< How strongly off-period gaps are penalised
+    static constexpr double minOnsetEnergy_ = 0.01;           ///< Recent onset energy needed to stay locked
+    static constexpr int beatSupportHops_ = 3;                ///< Hops either side of a beat an onset may land on to support it
+    static constexpr int maxUnsupportedBeats_ = 4;            ///< Beats in a row without an onset before letting go
+
+    double sampleRate_ = 44100.0;                             ///< Audio sample rate in Hz
+    int hopSamples_ = 512;                                    ///< Samples per hop
+    double acfDecay_ = 0.0;                                   ///< Per-hop decay of the autocorrelation (~8 s window)
+    double meanDecay_ = 0.0;                                  ///< Per-hop decay of the onset mean (~1 s)
+    double energyDecay_ = 0.0;                                ///< Per-hop decay of the recent onset energy (~2 s)
+
+    // Current hop
+    double hopEnergy_ = 0.0;                                  ///< Sum of squares so far
+    int hopFill_ = 0;                                         ///< Samples so far
+    float previousLogEnergy_ = 0.0f;                          ///< Log energy of the last hop
+    float onsetMean_ = 0.0f;                                  ///< Running mean onset strength
+    double onsetEnergy_ = 0.0;                                ///< Running mean squared onset strength
+    juce::int64 hopIndex_ = 0;                                ///< Hops processed
+
+    // Tempo
+    std::array<float, ringSize_> onsetRing_ {};               ///< Mean-removed onset strength per hop
+    std::array<double, numAcfLags_> autocorrelation_ {};      ///< Windowed autocorrelation per lag
+    double onsetPower_ = 0.0;                                 ///< Windowed autocorrelation at lag 0
+    float period_ = 43.0f;                                    ///< Beat period in hops (120 BPM)
+    float tempoStrength_ = 0.0f;                              ///< Normalised autocorrelation at the period
+    std::array<float, 2 * maxLag_ + 1> transitionWeights_ {}; ///< Weight of a gap of n hops between beats
+    std::array<float, maxLag_ + 1> tempoPrior_ {};            ///< Preference per lag
+
+    // Beat phase
+    std::array<float, ringSize_> scoreRing_ {};               ///< Cumulative score per hop
+    int hopsSinceBeat_ = 0;                                   ///< Hops since the last beat
+    int hopsToNextBeat_ = -1;                                 ///< Hops until the predicted beat (-1 = none)
+    bool predictedThisBeat_ = false;                          ///< Prediction done for the current beat
+    juce::int64 beatCount_ = 0;                               ///< Beats reported since the tracker last let go
+    int unsupportedBeats_ = 0;                                ///< Beats in a row without an onset near them
+    juce::int64 lastBeatSample_ = 0;                          ///< Stream position of the last beat
+
+    std::atomic<double> publishedBpm_ { 0.0 };                ///< For other threads
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BeatTracker)
+};
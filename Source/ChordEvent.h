@@ -0,0 +1,22 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+//==============================================================================
+/**
+ * One recorded chord change: the chord holds until the next change.
+ * Trivially copyable so it can travel through a LockFreeQueue.
+ */
+struct ChordEvent
+{
+    juce::int64 onsetSample = 0;        ///< Samples since the recording started
+    double onsetPpq = 0.0;              ///< Host timeline position in quarter notes
+    double onsetSeconds = 0.0;          ///< Host timeline position in seconds
+    float bpm = 0.0f;                   ///< Host tempo at the change
+    juce::int32 bar = 0;                ///< Host bar index of the change (0 = first bar)
+    juce::uint32 sessionId = 0;         ///< Recording session the event belongs to
+    juce::int8 root = -1;               ///< 0-11 (C = 0), or -1 for no chord
+    juce::int8 quality = 0;             ///< Index into CompileTimeTables::chordQualities
+    float confidence = 0.0f;            ///< Match score relative to a perfect match (0-1)
+    bool hasHostTime = false;           ///< Timeline fields are valid (host transport running, or a tracked beat)
+};
@@ -0,0 +1,164 @@
+#include "ChordRecognizer.h"
+#include <cstring>
+
+//==============================================================================
+juce::String DetectedChord::getName() const
+{
+    if (!isValid())
+        return {};
+
+    return juce::String(CompileTimeTables::noteNames[static_cast<size_t>(root)])
+           + CompileTimeTables::chordQualities[static_cast<size_t>(quality)].suffix;
+}
+
+//==============================================================================
+void ChordRecognizer::reset()
+{
+    current_ = {};
+    currentTemplate_ = -1;
+    published_.store(0, std::memory_order_release);
+}
+
+bool ChordRecognizer::process(const std::array<float, 12>& chroma)
+{
+    std::array<float, 12> normalised;
+    const auto activeMask = normalise(chroma, minimumLevel_.load(std::memory_order_relaxed), normalised);
+
+    float bestScore = 0.0f;
+    const int best = findBestTemplate(normalised, activeMask, bestScore);
+
+    if (best == currentTemplate_)
+    {
+        if (best >= 0)
+            current_ = makeChord(best, bestScore);
+
+        return false;
+    }
+
+    // Hold the current chord unless the newcomer is clearly better (or the current one is gone)
+    if (best >= 0 && currentTemplate_ >= 0)
+    {
+        const float currentScore = getScore(currentTemplate_, normalised);
+
+        if (bestScore < currentScore + switchMargin_ * CompileTimeTables::chordTemplates[static_cast<size_t>(best)].maxScore)
+        {
+            current_ = makeChord(currentTemplate_, currentScore);
+            return false;
+        }
+    }
+
+    currentTemplate_ = best;
+    current_ = best >= 0 ? makeChord(best, bestScore) : DetectedChord {};
+    publish();
+    return true;
+}
+
+DetectedChord ChordRecognizer::getChord() const
+{
+    const auto packed = published_.load(std::memory_order_acquire);
+    const int templateIndex = (int) (packed >> 32) - 1;
+
+    if (templateIndex < 0)
+        return {};
+
+    float confidence;
+    const auto confidenceBits = (juce::uint32) (packed & 0xffffffff);
+    std::memcpy(&confidence, &confidenceBits, sizeof(float));
+
+    const auto& chord = CompileTimeTables::chordTemplates[static_cast<size_t>(templateIndex)];
+    return { (int) chord.root, (int) chord.quality, confidence };
+}
+
+void ChordRecognizer::publish()
+{
+    juce::uint32 confidenceBits;
+    std::memcpy(&confidenceBits, &current_.confidence, sizeof(float));
+
+    published_.store(((juce::uint64) (juce::uint32) (currentTemplate_ + 1) << 32) | confidenceBits,
+                     std::memory_order_release);
+}
+
+//==============================================================================
+DetectedChord ChordRecognizer::recognize(const std::array<float, 12>& chroma, float minimumLevel)
+{
+    std::array<float, 12> normalised;
+    const auto activeMask = normalise(chroma, minimumLevel, normalised);
+
+    float bestScore = 0.0f;
+    const int best = findBestTemplate(normalised, activeMask, bestScore);
+    return best >= 0 ? makeChord(best, bestScore) : DetectedChord {};
+}
+
+juce::uint32 ChordRecognizer::normalise(const std::array<float, 12>& chroma, float minimumLevel,
+                                        std::array<float, 12>& normalised)
+{
+    float peak = 0.0f;
+    for (float magnitude : chroma)
+        peak = juce::jmax(peak, magnitude);
+
+    if (peak <= minimumLevel || peak <= 0.0f)
+        return 0;
+
+    juce::uint32 activeMask = 0;
+    for (int pitchClass = 0; pitchClass < 12; ++pitchClass)
+    {
+        normalised[static_cast<size_t>(pitchClass)] = chroma[static_cast<size_t>(pitchClass)] / peak;
+
+        if (normalised[static_cast<size_t>(pitchClass)] >= activeThreshold_)
+            activeMask |= 1u << pitchClass;
+    }
+
+    return activeMask;
+}
+
+int ChordRecognizer::findBestTemplate(const std::array<float, 12>& normalised, juce::uint32 activeMask, float& bestScore)
+{
+    // A single pitch class is a note, not a chord
+    if (juce::countNumberOfBits(activeMask) < 2)
+        return -1;
+
+    int best = -1;
+
+    for (int root = 0; root < 12; ++root)
+    {
+        if ((activeMask & (1u << root)) == 0)
+            continue;
+
+        for (int quality = 0; quality < CompileTimeTables::numChordQualities; ++quality)
+        {
+            const int templateIndex = root * CompileTimeTables::numChordQualities + quality;
+            const auto& chord = CompileTimeTables::chordTemplates[static_cast<size_t>(templateIndex)];
+
+            // Allow one chord tone to be missing (e.g. the fifth), but no more
+            if (juce::countNumberOfBits((juce::uint32) chord.mask & ~activeMask) > 1)
+                continue;
+
+            const float score = getScore(templateIndex, normalised);
+            if (best < 0 || score > bestScore)
+            {
+                best = templateIndex;
+                bestScore = score;
+            }
+        }
+    }
+
+    // A match that loses more to missing and extra tones than it gains isn't a chord
+    return bestScore > 0.0f ? best : -1;
+}
+
+float ChordRecognizer::getScore(int templateIndex, const std::array<float, 12>& normalised)
+{
+    const auto& chord = CompileTimeTables::chordTemplates[static_cast<size_t>(templateIndex)];
+
+    float score = chord.bias;
+    for (size_t pitchClass = 0; pitchClass < 12; ++pitchClass)
+        score += chord.weights[pitchClass] * normalised[pitchClass];
+
+    return score;
+}
+
+DetectedChord ChordRecognizer::makeChord(int templateIndex, float score)
+{
+    const auto& chord = CompileTimeTables::chordTemplates[static_cast<size_t>(templateIndex)];
+    return { (int) chord.root, (int) chord.quality, juce::jlimit(0.0f, 1.0f, score / chord.maxScore) };
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "CompileTimeTables.h"
+#include <array>
+#include <atomic>
+
+//==============================================================================
+/** A recognised chord. */
+struct DetectedChord
+{
+    int root = -1;                      ///< 0-11 (C = 0), or -1 for no chord
+    int quality = 0;                    ///< Index into CompileTimeTables::chordQualities
+    float confidence = 0.0f;            ///< Match score relative to a perfect match (0-1)
+
+    /** Checks if a chord was recognised. */
+    bool isValid() const { return root >= 0; }
+
+    /** Gets the chord symbol, e.g. "Am7" (empty if there is no chord). */
+    juce::String getName() const;
+};
+
+//==============================================================================
+/**
+ * Recognises chords from a chroma vector by template matching.
+ *
+ * The chroma is normalised to a peak of 1 and reduced to a 12-bit mask of
+ * active pitch classes. Only templates rooted on an active pitch class and
+ * missing at most one of their tones are scored, and a score is a single
+ * 12-term dot product with the template's precomputed weights (see
+ * CompileTimeTables::ChordTemplate), so a frame costs a few hundred
+ * operations. The current chord is kept until another fits clearly better,
+ * which stops the symbol flickering between near-equal readings.
+ *
+ * process() runs on the audio thread; the current chord is published in a
+ * single atomic word and can be read from any thread.
+ */
+class ChordRecognizer
+{
+public:
+    //==============================================================================
+    ChordRecognizer() = default;
+
+    /** Forgets the current chord. */
+    void reset();
+
+    /**
+     * Matches a chroma vector (audio thread).
+     *
+     * @param chroma Magnitude per pitch class, C = 0
+     * @return true if the current chord changed
+     */
+    bool process(const std::array<float, 12>& chroma);
+
+    /** Gets the current chord (audio thread). */
+    const DetectedChord& getCurrentChord() const { return current_; }
+
+    /** Gets the latest published chord. Lock-free; any thread. */
+    DetectedChord getChord() const;
+
+    /** Sets the chroma peak below which nothing is recognised. Thread-safe. */
+    void setMinimumLevel(float level) { minimumLevel_.store(juce::jmax(0.0f, level), std::memory_order_relaxed); }
+
+    //==============================================================================
+    /** Finds the best matching chord for a chroma vector, with no memory of earlier frames. */
+    static DetectedChord recognize(const std::array<float, 12>& chroma, float minimumLevel);
+
+private:
+    //==============================================================================
+    /**
+     * Scales a chroma vector to a peak of 1.
+     *
+     * @return Mask of the pitch classes above activeThreshold_, or 0 if the peak is below minimumLevel
+     */
+    static juce::uint32 normalise(const std::array<float, 12>& chroma, float minimumLevel, std::array<float, 12>& normalised);
+
+    /** Finds the best template for a normalised chroma vector and its mask. */
+    static int findBestTemplate(const std::array<float, 12>& normalised, juce::uint32 activeMask, float& bestScore);
+
+    /** Gets a template's score for a normalised chroma vector. */
+    static float getScore(int templateIndex, const std::array<float, 12>& normalised);
+
+    /** Makes the result for a template and its score. */
+    static DetectedChord makeChord(int templateIndex, float score);
+
+    /** Publishes current_ for other threads. */
+    void publish();
+
+    static constexpr float activeThreshold_ = 0.3f;           ///< Fraction of the peak a pitch class needs to count
+    static constexpr float switchMargin_ = 0.15f;             ///< Score lead another chord needs to replace the current one
+
+    DetectedChord current_;                                   ///< Chord being held (audio thread)
+    int currentTemplate_ = -1;                                ///< Its template
+
+    std::atomic<float> minimumLevel_{ 0.01f };                ///< Chroma peak needed for a chord
+    std::atomic<juce::uint64> published_{ 0 };                ///< Template + 1 (high word), confidence bits (low word)
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChordRecognizer)
+};
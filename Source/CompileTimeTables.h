@@ -0,0 +1,307 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+//==============================================================================
+/**
+ * Lookup tables evaluated entirely at compile time.
+ *
+ * Everything here is constexpr so that constructing a detector (e.g. during a
+ * host's plugin scan) costs no trigonometry, allocation or string building.
+ * Sines and cosines are produced by rotating a unit vector by a small step
+ * whose sin/cos come from a short Taylor series, which keeps the number of
+ * constant-evaluation steps low enough for every supported compiler.
+ */
+namespace CompileTimeTables
+{
+    constexpr int fftOrder = 12;                              ///< Frame size the tables are generated for
+    constexpr int fftSize = 1 << fftOrder;                    ///< 4096
+
+    constexpr int lowestMappedNote = 24;                      ///< MIDI C1 (~33 Hz)
+    constexpr int highestMappedNote = 96;                     ///< MIDI C7
+    constexpr int numMappedNotes = highestMappedNote - lowestMappedNote + 1;
+
+    /** Frequency range mapping for a musical note. */
+    struct NoteFrequencyRange
+    {
+        const char* noteName;
+        float minFrequency;
+        float maxFrequency;
+        float centerFrequency;
+        int midiNoteNumber;
+    };
+
+    /** Window shapes with compile-time coefficient tables. */
+    enum class WindowShape { hann, blackmanHarris };
+
+    //==============================================================================
+    constexpr double pi = 3.141592653589793238;
+    constexpr double semitoneRatio = 1.0594630943592952646;   ///< 2^(1/12)
+    constexpr double quarterToneRatio = 1.0293022366434920287; ///< 2^(1/24)
+
+    inline constexpr std::array<const char*, 12> noteNames = {
+        "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"
+    };
+
+    /** sin(x) for |x| well below 1 (exact to double precision for the steps used here). */
+    constexpr double smallAngleSin(double x)
+    {
+        double term = x, sum = x;
+        for (int n = 1; n < 8; ++n)
+        {
+            term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+            sum += term;
+        }
+        return sum;
+    }
+
+    /** cos(x) for |x| well below 1. */
+    constexpr double smallAngleCos(double x)
+    {
+        double term = 1.0, sum = 1.0;
+        for (int n = 1; n < 8; ++n)
+        {
+            term *= -x * x / ((2.0 * n - 1.0) * (2.0 * n));
+            sum += term;
+        }
+        return sum;
+    }
+
+    /** Frequency = 440 * 2^((midiNote - 69) / 12), by repeated semitone steps from A4. */
+    constexpr double midiNoteToFrequency(int midiNote)
+    {
+        double frequency = 440.0;
+        for (int n = 69; n < midiNote; ++n)
+            frequency *= semitoneRatio;
+        for (int n = 69; n > midiNote; --n)
+            frequency /= semitoneRatio;
+        return frequency;
+    }
+
+    //==============================================================================
+    /** Symmetric window of `Size` points: w(n) uses cos(2π * n / (N-1)). */
+    template <int Size>
+    constexpr std::array<float, Size> makeWindow(WindowShape shape)
+    {
+        std::array<float, Size> window {};
+        const double step = 2.0 * pi / (Size - 1);
+        const double stepCos = smallAngleCos(step), stepSin = smallAngleSin(step);
+        double c = 1.0, s = 0.0;
+
+        // Only the first half is computed; the window is symmetric
+        for (int i = 0; i < (Size + 1) / 2; ++i)
+        {
+            double value = 0.5 * (1.0 - c);  // Hann
+
+            if (shape == WindowShape::blackmanHarris)
+            {
+                const double c2 = 2.0 * c * c - 1.0;         // cos(2x)
+                const double c3 = (4.0 * c * c - 3.0) * c;   // cos(3x)
+                value = 0.35875 - 0.48829 * c + 0.14128 * c2 - 0.01168 * c3;
+            }
+
+            window[static_cast<std::size_t>(i)] = static_cast<float>(value);
+            window[static_cast<std::size_t>(Size - 1 - i)] = static_cast<float>(value);
+
+            const double nextC = c * stepCos - s * stepSin;
+            s = s * stepCos + c * stepSin;
+            c = nextC;
+        }
+
+        return window;
+    }
+
+    /** exp(-2πik / Size) for k < Size / 2, as interleaved (real, imag) pairs. */
+    template <int Size>
+    constexpr std::array<float, Size> makeTwiddles()
+    {
+        std::array<float, Size> twiddles {};
+        const double step = 2.0 * pi / Size;
+        const double stepCos = smallAngleCos(step), stepSin = smallAngleSin(step);
+        double c = 1.0, s = 0.0;
+
+        for (int k = 0; k < Size / 2; ++k)
+        {
+            twiddles[static_cast<std::size_t>(2 * k)] = static_cast<float>(c);
+            twiddles[static_cast<std::size_t>(2 * k + 1)] = static_cast<float>(-s);
+
+            const double nextC = c * stepCos - s * stepSin;
+            s = s * stepCos + c * stepSin;
+            c = nextC;
+        }
+
+        return twiddles;
+    }
+
+    /** Note ranges from C1 to C7; boundaries are the geometric means between adjacent notes. */
+    constexpr std::array<NoteFrequencyRange, numMappedNotes> makeFrequencyMap()
+    {
+        std::array<NoteFrequencyRange, numMappedNotes> map {};
+        double center = midiNoteToFrequency(lowestMappedNote);
+
+        for (int i = 0; i < numMappedNotes; ++i)
+        {
+            const int midiNote = lowestMappedNote + i;
+
+            // sqrt(f(n-1) * f(n)) = f(n) / 2^(1/24)
+            map[static_cast<std::size_t>(i)] = { noteNames[static_cast<std::size_t>(midiNote % 12)],
+                                            static_cast<float>(center / quarterToneRatio),
+                                            static_cast<float>(center * quarterToneRatio),
+                                            static_cast<float>(center),
+                                            midiNote };
+            center *= semitoneRatio;
+        }
+
+        return map;
+    }
+
+    //==============================================================================
+    constexpr int numKeys = 24;                               ///< 12 major keys (C..B), then 12 minor
+
+    /** Krumhansl-Kessler probe-tone ratings, from the tonic upwards. */
+    inline constexpr std::array<double, 12> majorKeyProfile = { 6.35, 2.23, 3.48, 2.33, 4.38, 4.09, 2.52, 5.19, 2.39, 3.66, 2.29, 2.88 };
+    inline constexpr std::array<double, 12> minorKeyProfile = { 6.33, 2.68, 3.52, 5.38, 2.60, 3.53, 2.54, 4.75, 3.98, 2.69, 3.34, 3.17 };
+
+    /** sqrt(x) for x > 0 by Newton iteration. */
+    constexpr double newtonSqrt(double x)
+    {
+        double root = x > 1.0 ? x : 1.0;
+        for (int n = 0; n < 64; ++n)
+            root = 0.5 * (root + x / root);
+        return root;
+    }
+
+    /**
+     * One row per key: the profile rotated to the key's tonic, mean-removed and
+     * scaled to unit length. A row's dot product with any pitch-class histogram
+     * is then its Pearson correlation times the histogram's (key-independent)
+     * spread, so the best key is simply the largest dot product.
+     */
+    constexpr std::array<std::array<float, 12>, numKeys> makeKeyProfileMatrix()
+    {
+        std::array<std::array<float, 12>, numKeys> matrix {};
+
+        for (int key = 0; key < numKeys; ++key)
+        {
+            const auto& profile = key < 12 ? majorKeyProfile : minorKeyProfile;
+            const int tonic = key % 12;
+
+            double mean = 0.0;
+            for (double rating : profile)
+                mean += rating / 12.0;
+
+            double sumOfSquares = 0.0;
+            for (double rating : profile)
+                sumOfSquares += (rating - mean) * (rating - mean);
+
+            const double scale = 1.0 / newtonSqrt(sumOfSquares);
+
+            for (int pitchClass = 0; pitchClass < 12; ++pitchClass)
+                matrix[static_cast<std::size_t>(key)][static_cast<std::size_t>(pitchClass)]
+                    = static_cast<float>((profile[static_cast<std::size_t>((pitchClass - tonic + 12) % 12)] - mean) * scale);
+        }
+
+        return matrix;
+    }
+
+    //==============================================================================
+    /** A chord type: its name suffix and how much each interval above the root counts. */
+    struct ChordQuality
+    {
+        const char* suffix;                 ///< Appended to the root's name, e.g. "m7"
+        std::array<float, 12> toneWeights;  ///< Per semitone above the root; 0 = not in the chord
+    };
+
+    /** Triads, sus, power chords, sevenths and extensions. Fifths and colour tones count for less than root and third. */
+    inline constexpr std::array<ChordQuality, 19> chordQualities = { {
+        //              1     b9    9     b3    3     4     b5    5     #5    6     b7    7
+        { "",       { { 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.8f, 0.0f, 0.0f, 0.0f, 0.0f } } },
+        { "m",      { { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.8f, 0.0f, 0.0f, 0.0f, 0.0f } } },
+        { "dim",    { { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.8f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f } } },
+        { "aug",    { { 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.8f, 0.0f, 0.0f, 0.0f } } },
+        { "sus2",   { { 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.8f, 0.0f, 0.0f, 0.0f, 0.0f } } },
+        { "sus4",   { { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.8f, 0.0f, 0.0f, 0.0f, 0.0f } } },
+        { "5",      { { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.8f, 0.0f, 0.0f, 0.0f, 0.0f } } },
+        { "7",      { { 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.8f, 0.0f, 0.0f, 0.8f, 0.0f } } },
+        { "maj7",   { { 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.8f, 0.0f, 0.0f, 0.0f, 0.8f } } },
+        { "m7",     { { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.8f, 0.0f, 0.0f, 0.8f, 0.0f } } },
+        { "m7b5",   { { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.8f, 0.0f, 0.0f, 0.0f, 0.8f, 0.0f } } },
+        { "dim7",   { { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.8f, 0.0f, 0.0f, 0.8f, 0.0f, 0.0f } } },
+        { "7sus4",  { { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.8f, 0.0f, 0.0f, 0.8f, 0.0f } } },
+        { "6",      { { 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.8f, 0.0f, 0.6f, 0.0f, 0.0f } } },
+        { "m6",     { { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.8f, 0.0f, 0.6f, 0.0f, 0.0f } } },
+        { "add9",   { { 1.0f, 0.0f, 0.6f, 0.0f, 1.0f, 0.0f, 0.0f, 0.8f, 0.0f, 0.0f, 0.0f, 0.0f } } },
+        { "9",      { { 1.0f, 0.0f, 0.6f, 0.0f, 1.0f, 0.0f, 0.0f, 0.8f, 0.0f, 0.0f, 0.8f, 0.0f } } },
+        { "maj9",   { { 1.0f, 0.0f, 0.6f, 0.0f, 1.0f, 0.0f, 0.0f, 0.8f, 0.0f, 0.0f, 0.0f, 0.8f } } },
+        { "m9",     { { 1.0f, 0.0f, 0.6f, 1.0f, 0.0f, 0.0f, 0.0f, 0.8f, 0.0f, 0.0f, 0.8f, 0.0f } } }
+    } };
+
+    constexpr int numChordQualities = static_cast<int>(chordQualities.size());
+    constexpr int numChordTemplates = 12 * numChordQualities;    ///< Every quality on every root, root-major
+
+    constexpr float chordMissingTonePenalty = 0.5f;           ///< Score lost per unit weight of an absent chord tone
+    constexpr float chordExtraTonePenalty = 0.5f;             ///< Score lost per unit of energy outside the chord
+
+    /**
+     * One quality on one root, ready for matching against a chroma vector
+     * normalised to a peak of 1. The score is bias + weights . chroma, which
+     * expands to: chord tones present, minus chord tones missing, minus energy
+     * outside the chord. maxScore is the score of a perfect match.
+     */
+    struct ChordTemplate
+    {
+        std::uint16_t mask;                 ///< Bit n set = pitch class n is a chord tone
+        std::uint8_t root;                  ///< 0-11, C = 0
+        std::uint8_t quality;               ///< Index into chordQualities
+        std::array<float, 12> weights;      ///< Per pitch class
+        float bias;                         ///< Constant part of the missing-tone penalty
+        float maxScore;                     ///< Sum of the tone weights
+    };
+
+    constexpr std::array<ChordTemplate, numChordTemplates> makeChordTemplates()
+    {
+        std::array<ChordTemplate, numChordTemplates> templates {};
+
+        for (int root = 0; root < 12; ++root)
+        {
+            for (int quality = 0; quality < numChordQualities; ++quality)
+            {
+                auto& chord = templates[static_cast<std::size_t>(root * numChordQualities + quality)];
+                chord.root = static_cast<std::uint8_t>(root);
+                chord.quality = static_cast<std::uint8_t>(quality);
+
+                for (int pitchClass = 0; pitchClass < 12; ++pitchClass)
+                {
+                    const float toneWeight = chordQualities[static_cast<std::size_t>(quality)]
+                                                 .toneWeights[static_cast<std::size_t>((pitchClass - root + 12) % 12)];
+                    auto& weight = chord.weights[static_cast<std::size_t>(pitchClass)];
+
+                    if (toneWeight > 0.0f)
+                    {
+                        chord.mask = static_cast<std::uint16_t>(chord.mask | (1u << pitchClass));
+                        weight = toneWeight * (1.0f + chordMissingTonePenalty);
+                        chord.bias -= toneWeight * chordMissingTonePenalty;
+                        chord.maxScore += toneWeight;
+                    }
+                    else
+                    {
+                        weight = -chordExtraTonePenalty;
+                    }
+                }
+            }
+        }
+
+        return templates;
+    }
+
+    //==============================================================================
+    // Inline, so every translation unit shares one copy instead of building its own
+    inline constexpr auto hannWindow = makeWindow<fftSize>(WindowShape::hann);
+    inline constexpr auto blackmanHarrisWindow = makeWindow<fftSize>(WindowShape::blackmanHarris);
+    inline constexpr auto twiddles = makeTwiddles<fftSize>();
+    inline constexpr auto frequencyMap = makeFrequencyMap();
+    inline constexpr auto keyProfileMatrix = makeKeyProfileMatrix();
+    inline constexpr auto chordTemplates = makeChordTemplates();
+}
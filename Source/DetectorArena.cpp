@@ -0,0 +1,79 @@
+#include "DetectorArena.h"
+
+#if JUCE_WINDOWS
+ #include <windows.h>
+#else
+ #include <sys/mman.h>
+ #include <unistd.h>
+#endif
+
+//==============================================================================
+bool DetectorArena::allocate(bool lockPages)
+{
+    if (base_ != nullptr)
+    {
+        setPagesLocked(false);
+        storage_.free();
+        base_ = nullptr;
+    }
+
+    if (layoutSize_ == 0)
+        return false;
+
+    // Over-allocate so the block can start on a cache line boundary
+    allocatedBytes_ = layoutSize_ + alignment - 1;
+    storage_.malloc(allocatedBytes_);
+
+    if (storage_.getData() == nullptr)
+        return false;
+
+    const auto address = reinterpret_cast<uintptr_t>(storage_.getData());
+    base_ = storage_.getData() + (alignUp(address) - address);
+
+    // Zeroing writes to every page, so none of them faults on first use
+    juce::zeromem(base_, layoutSize_);
+
+    if (lockPages)
+        setPagesLocked(true);
+
+    return true;
+}
+
+void DetectorArena::release()
+{
+    if (base_ != nullptr)
+        setPagesLocked(false);
+
+    storage_.free();
+    base_ = nullptr;
+    layoutSize_ = 0;
+    allocatedBytes_ = 0;
+}
+
+bool DetectorArena::setPagesLocked(bool shouldLock)
+{
+    if (shouldLock == locked_)
+        return true;
+
+   #if JUCE_WINDOWS
+    const bool ok = shouldLock ? VirtualLock(base_, layoutSize_) != 0
+                               : VirtualUnlock(base_, layoutSize_) != 0;
+   #else
+    // Lock whole pages spanning the block
+    const auto pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const auto first = reinterpret_cast<uintptr_t>(base_) & ~(pageSize - 1);
+    const auto last = (reinterpret_cast<uintptr_t>(base_) + layoutSize_ + pageSize - 1) & ~(pageSize - 1);
+    auto* start = reinterpret_cast<void*>(first);
+
+    const bool ok = shouldLock ? mlock(start, last - first) == 0
+                               : munlock(start, last - first) == 0;
+   #endif
+
+    // Locking is best-effort (it fails without enough RLIMIT_MEMLOCK / working set quota)
+    if (shouldLock)
+        locked_ = ok;
+    else if (ok)
+        locked_ = false;
+
+    return ok;
+}
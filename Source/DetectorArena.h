@@ -0,0 +1,91 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <type_traits>
+
+//==============================================================================
+/**
+ * One contiguous, cache-line aligned memory block holding all of a detector's
+ * working buffers.
+ *
+ * Buffers are laid out with reserve() before allocate() is called; each one
+ * starts on its own 64-byte boundary. The block is zeroed on allocation, which
+ * also pre-touches every page, and can optionally be locked into physical memory
+ * so the audio thread never takes a page fault on it.
+ */
+class DetectorArena
+{
+public:
+    //==============================================================================
+    static constexpr size_t alignment = 64;                   ///< Cache line size
+
+    DetectorArena() = default;
+    ~DetectorArena() { release(); }
+
+    /**
+     * Reserves space for an array in the next allocation.
+     *
+     * @param count Number of elements
+     * @return Byte offset of the array within the arena
+     */
+    template <typename Type>
+    size_t reserve(size_t count)
+    {
+        static_assert(std::is_trivially_copyable<Type>::value && alignof(Type) <= alignment,
+                      "Arena storage is raw zeroed memory");
+        jassert(base_ == nullptr);  // The layout can't change once allocated
+
+        const auto offset = layoutSize_;
+        layoutSize_ = alignUp(layoutSize_ + count * sizeof(Type));
+        return offset;
+    }
+
+    /**
+     * Allocates, zeroes and optionally page-locks the reserved layout.
+     * Not real-time safe.
+     *
+     * @param lockPages true to lock the block into physical memory
+     * @return false if allocation failed
+     */
+    bool allocate(bool lockPages);
+
+    /** Frees the block and clears the layout so a new one can be reserved. */
+    void release();
+
+    /**
+     * Gets a reserved array.
+     *
+     * @param offset Offset returned by reserve()
+     * @return Pointer into the arena
+     */
+    template <typename Type>
+    Type* get(size_t offset) const
+    {
+        jassert(base_ != nullptr && offset < layoutSize_);
+        return reinterpret_cast<Type*>(base_ + offset);
+    }
+
+    /** Returns true once allocate() succeeded. */
+    bool isAllocated() const { return base_ != nullptr; }
+
+    /** Returns true if the block is locked into physical memory. */
+    bool isLocked() const { return locked_; }
+
+    /** Gets the number of bytes the heap allocation occupies, including alignment slack. */
+    size_t getAllocatedBytes() const { return base_ != nullptr ? allocatedBytes_ : 0; }
+
+private:
+    //==============================================================================
+    static size_t alignUp(size_t size) { return (size + alignment - 1) & ~(alignment - 1); }
+
+    /** Locks or unlocks the pages spanning the block. */
+    bool setPagesLocked(bool shouldLock);
+
+    juce::HeapBlock<char> storage_;                           ///< Raw allocation (over-sized for alignment)
+    char* base_ = nullptr;                                    ///< First aligned byte of storage_
+    size_t layoutSize_ = 0;                                   ///< Bytes reserved so far
+    size_t allocatedBytes_ = 0;                               ///< Size of storage_
+    bool locked_ = false;                                     ///< Pages locked into physical memory
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DetectorArena)
+};
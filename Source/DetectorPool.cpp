@@ -0,0 +1,265 @@
+#include "DetectorPool.h"
+
+//==============================================================================
+/**
+ * A pool thread with its own queue of streams ready to analyse. The queue
+ * holds each stream at most once, so it never needs more slots than there
+ * are streams.
+ */
+class DetectorPool::Worker : private juce::Thread
+{
+public:
+    Worker(DetectorPool& pool, int index)
+        : juce::Thread("Detector Pool " + juce::String(index))
+        , pool_(pool)
+        , index_(index)
+        , slots_(pool.streams_.size() + 1)
+    {
+    }
+
+    ~Worker() override
+    {
+        stop();
+    }
+
+    void start() { startThread(); }
+
+    void stop()
+    {
+        signalThreadShouldExit();
+        wake();
+        stopThread(-1);
+    }
+
+    void wake() { work_.signal(); }
+
+    /** Adds a stream to the back of the queue (any thread). */
+    void push(int stream)
+    {
+        const juce::SpinLock::ScopedLockType lock(lock_);
+
+        slots_[(first_ + size_) % slots_.size()] = stream;
+        ++size_;
+    }
+
+    /** Takes the stream at the front of the queue (owner) or the back (thief). */
+    bool take(int& stream, bool fromFront)
+    {
+        const juce::SpinLock::ScopedLockType lock(lock_);
+
+        if (size_ == 0)
+            return false;
+
+        if (fromFront)
+        {
+            stream = slots_[first_];
+            first_ = (first_ + 1) % slots_.size();
+        }
+        else
+        {
+            stream = slots_[(first_ + size_ - 1) % slots_.size()];
+        }
+
+        --size_;
+        return true;
+    }
+
+    /** Gets the number of streams queued. */
+    size_t getNumQueued() const
+    {
+        const juce::SpinLock::ScopedLockType lock(lock_);
+        return size_;
+    }
+
+private:
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            int stream = 0;
+
+            if (pool_.takeTask(index_, stream))
+                pool_.runTask(index_, stream);
+            else
+                work_.wait(idleWaitMs_);
+        }
+    }
+
+    DetectorPool& pool_;
+    const int index_;
+    mutable juce::SpinLock lock_;                             ///< Guards the queue (held for a few instructions)
+    std::vector<int> slots_;                                  ///< Queued stream indices, as a ring
+    size_t first_ = 0;                                        ///< Front of the ring
+    size_t size_ = 0;                                         ///< Streams queued
+    juce::WaitableEvent work_;                                ///< Wakes the thread for new work
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Worker)
+};
+
+//==============================================================================
+DetectorPool::DetectorPool() = default;
+
+DetectorPool::~DetectorPool()
+{
+    stop();
+}
+
+int DetectorPool::addStream(double sampleRate, const std::function<void (PitchDetector&)>& configure)
+{
+    jassert(workers_.empty());  // Workers size their queues for the streams they were started with
+
+    auto stream = std::make_unique<Stream>();
+
+    if (configure != nullptr)
+        configure(stream->detector);
+
+    stream->detector.setAmortisedAnalysisEnabled(false);
+    stream->detector.prepare(sampleRate, PitchDetector::getFFTSize());
+    stream->detector.setSourceChannel(getNumStreams());
+
+    streams_.push_back(std::move(stream));
+    return getNumStreams() - 1;
+}
+
+void DetectorPool::clearStreams()
+{
+    jassert(workers_.empty());
+    streams_.clear();
+}
+
+void DetectorPool::start(int numThreads)
+{
+    if (!workers_.empty())
+        return;
+
+    const int count = numThreads > 0 ? numThreads : juce::jmax(1, juce::SystemStats::getNumCpus());
+
+    for (int index = 0; index < count; ++index)
+        workers_.push_back(std::make_unique<Worker>(*this, index));
+
+    for (auto& worker : workers_)
+        worker->start();
+}
+
+void DetectorPool::stop()
+{
+    for (auto& worker : workers_)
+        worker->stop();
+
+    workers_.clear();
+
+    // Nothing is left queued, so whatever is still waiting is finished here
+    for (auto& stream : streams_)
+    {
+        Block block;
+        while (stream->blocks.pop(block))
+            analyseBlock(*stream, block);
+
+        stream->queued = false;
+    }
+}
+
+//==============================================================================
+juce::uint64 DetectorPool::submit(int stream, const float* audioData, int numSamples, const float* referenceData)
+{
+    auto& target = *streams_[static_cast<size_t>(stream)];
+    const Block block { audioData, numSamples, referenceData };
+
+    if (workers_.empty())
+    {
+        const auto ticket = target.numSubmitted.fetch_add(1) + 1;
+        analyseBlock(target, block);
+        return ticket;
+    }
+
+    if (!target.blocks.push(block))
+        return 0;
+
+    const auto ticket = target.numSubmitted.fetch_add(1) + 1;
+    schedule(stream, static_cast<int>(nextWorker_.fetch_add(1, std::memory_order_relaxed) % workers_.size()));
+    return ticket;
+}
+
+juce::uint64 DetectorPool::getNumBlocksCompleted(int stream) const
+{
+    return streams_[static_cast<size_t>(stream)]->numCompleted.load(std::memory_order_acquire);
+}
+
+bool DetectorPool::popResult(int stream, PitchDetector::FrameResult& result)
+{
+    return streams_[static_cast<size_t>(stream)]->results.pop(result);
+}
+
+int DetectorPool::getNumDroppedResults(int stream) const
+{
+    return streams_[static_cast<size_t>(stream)]->results.getNumDropped();
+}
+
+//==============================================================================
+void DetectorPool::schedule(int stream, int worker)
+{
+    if (streams_[static_cast<size_t>(stream)]->queued.exchange(true))
+        return;
+
+    workers_[static_cast<size_t>(worker)]->push(stream);
+    workers_[static_cast<size_t>(worker)]->wake();
+}
+
+bool DetectorPool::takeTask(int worker, int& stream)
+{
+    const int numWorkers = getNumThreads();
+    auto& own = *workers_[static_cast<size_t>(worker)];
+
+    if (own.take(stream, true))
+    {
+        // More waiting behind it - wake a neighbour to come and steal
+        if (numWorkers > 1 && own.getNumQueued() > 0)
+            workers_[static_cast<size_t>((worker + 1) % numWorkers)]->wake();
+
+        return true;
+    }
+
+    for (int offset = 1; offset < numWorkers; ++offset)
+        if (workers_[static_cast<size_t>((worker + offset) % numWorkers)]->take(stream, false))
+            return true;
+
+    return false;
+}
+
+void DetectorPool::runTask(int worker, int stream)
+{
+    auto& target = *streams_[static_cast<size_t>(stream)];
+    Block block;
+
+    for (int i = 0; i < maxBlocksPerTask_ && target.blocks.pop(block); ++i)
+        analyseBlock(target, block);
+
+    // A block submitted after the last pop may have found the stream still queued,
+    // so look again once it's released (both sides use sequentially consistent order)
+    target.queued = false;
+
+    if (target.blocks.getNumReady() > 0)
+        schedule(stream, worker);
+}
+
+void DetectorPool::analyseBlock(Stream& stream, const Block& block)
+{
+    // No more than a frame at a time, so no result is overwritten before it's delivered
+    for (int done = 0; done < block.numSamples;)
+    {
+        const int length = juce::jmin(block.numSamples - done, PitchDetector::getFFTSize());
+        stream.detector.processAudioBlock(block.audioData + done, length,
+                                          block.referenceData != nullptr ? block.referenceData + done : nullptr);
+
+        const auto& frame = stream.detector.getLatestFrame();
+        if (frame.frameIndex != stream.lastFrameIndex)
+        {
+            stream.lastFrameIndex = frame.frameIndex;
+            stream.results.push(frame);
+        }
+
+        done += length;
+    }
+
+    stream.numCompleted.fetch_add(1, std::memory_order_release);
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "LockFreeQueue.h"
+#include "PitchDetector.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/**
+ * Analyses many independent mono streams on a pool of worker threads, for
+ * offline tagging of an archive or live multitrack feeds outside a DAW.
+ *
+ * Each stream owns its own PitchDetector. Blocks are submitted by pointer and
+ * read in place, so the caller's buffer must stay valid until
+ * getNumBlocksCompleted() reaches the ticket submit() returned. A stream with
+ * blocks waiting is queued on one worker; idle workers steal queued streams
+ * from the others, so the load evens out whatever the mix of streams. A stream
+ * is only ever analysed by one worker at a time, in submission order, and
+ * every frame result it publishes is delivered through its own wait-free
+ * queue, in order.
+ *
+ * Streams are added and removed while the pool is stopped. Without running
+ * threads, submit() analyses the block on the calling thread.
+ */
+class DetectorPool
+{
+public:
+    //==============================================================================
+    static constexpr int blockQueueCapacity = 64;             ///< Blocks a stream can have waiting
+    static constexpr int resultQueueCapacity = 64;            ///< Results a stream can hold undelivered
+
+    DetectorPool();
+    ~DetectorPool();
+
+    /**
+     * Adds a stream and prepares its detector. Not real-time safe; the pool
+     * must be stopped. Amortised analysis is turned off, since there is no
+     * callback deadline to spread the work over.
+     *
+     * @param sampleRate Sample rate of the stream in Hz
+     * @param configure  Settings to apply to the detector before it is prepared, or nullptr
+     * @return Index of the new stream
+     */
+    int addStream(double sampleRate, const std::function<void (PitchDetector&)>& configure = nullptr);
+
+    /** Removes every stream. The pool must be stopped. */
+    void clearStreams();
+
+    /** Gets the number of streams. */
+    int getNumStreams() const { return static_cast<int>(streams_.size()); }
+
+    /**
+     * Starts the worker threads. Not real-time safe. Does nothing if they're already running.
+     *
+     * @param numThreads Workers to start, or 0 for one per CPU core
+     */
+    void start(int numThreads = 0);
+
+    /**
+     * Stops the worker threads. Blocks still waiting are then analysed on the
+     * calling thread, so every ticket completes. Not real-time safe, and not
+     * while blocks are being submitted.
+     */
+    void stop();
+
+    /** Gets the number of running worker threads. */
+    int getNumThreads() const { return static_cast<int>(workers_.size()); }
+
+    //==============================================================================
+    /**
+     * Queues a block of a stream for analysis. Wait-free when the pool is
+     * running. Only one thread may submit to a given stream.
+     *
+     * @param stream        Stream index
+     * @param audioData     Mono samples, read in place
+     * @param numSamples    Number of samples
+     * @param referenceData Accompaniment reference for the same samples, or nullptr
+     * @return Ticket of the block (a stream's blocks count from 1), or 0 if its queue was full
+     */
+    juce::uint64 submit(int stream, const float* audioData, int numSamples, const float* referenceData = nullptr);
+
+    /** Gets how many of a stream's blocks have been analysed; buffers of blocks up to that ticket can be reused. */
+    juce::uint64 getNumBlocksCompleted(int stream) const;
+
+    /**
+     * Removes a stream's oldest undelivered result. Only one thread may pop from a given stream.
+     *
+     * @return false if there was none
+     */
+    bool popResult(int stream, PitchDetector::FrameResult& result);
+
+    /** Gets the number of a stream's results dropped because they weren't popped in time. */
+    int getNumDroppedResults(int stream) const;
+
+private:
+    //==============================================================================
+    /** A submitted block, read in place. */
+    struct Block
+    {
+        const float* audioData = nullptr;
+        int numSamples = 0;
+        const float* referenceData = nullptr;
+    };
+
+    /** One analysed stream. */
+    struct Stream
+    {
+        PitchDetector detector;
+        LockFreeQueue<Block> blocks { blockQueueCapacity };                         ///< Submitter -> worker
+        LockFreeQueue<PitchDetector::FrameResult> results { resultQueueCapacity };  ///< Worker -> consumer
+        std::atomic<bool> queued { false };                   ///< In a worker's queue or being analysed
+        std::atomic<juce::uint64> numSubmitted { 0 };         ///< Blocks accepted by submit()
+        std::atomic<juce::uint64> numCompleted { 0 };         ///< Blocks analysed
+        juce::uint32 lastFrameIndex = 0;                      ///< Last result delivered
+    };
+
+    class Worker;
+
+    /**
+     * Queues a stream on a worker unless it's already queued or being analysed.
+     *
+     * @param stream Stream index
+     * @param worker Worker to queue it on
+     */
+    void schedule(int stream, int worker);
+
+    /**
+     * Takes the next stream to analyse: the oldest on a worker's own queue,
+     * or else the newest on another worker's.
+     *
+     * @param worker Index of the asking worker
+     * @param stream Receives the stream index
+     * @return false if every queue was empty
+     */
+    bool takeTask(int worker, int& stream);
+
+    /** Analyses some of a stream's waiting blocks, then queues it again if any are left. */
+    void runTask(int worker, int stream);
+
+    /** Analyses one block, delivering every frame result it completes. */
+    void analyseBlock(Stream& stream, const Block& block);
+
+    static constexpr int maxBlocksPerTask_ = 8;               ///< Blocks a worker analyses before moving on to another stream
+    static constexpr int idleWaitMs_ = 10;                    ///< Longest a worker sleeps before looking for work to steal
+
+    std::vector<std::unique_ptr<Stream>> streams_;            ///< Every stream
+    std::vector<std::unique_ptr<Worker>> workers_;            ///< Running workers (empty when stopped)
+    std::atomic<juce::uint32> nextWorker_ { 0 };              ///< Round-robin target for newly queued streams
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DetectorPool)
+};
@@ -0,0 +1,101 @@
+#include "DetectorWorker.h"
+
+//==============================================================================
+DetectorWorker::DetectorWorker()
+    : juce::Thread("Detector Worker")
+{
+    // Started by the processor only when a second channel needs analysing
+}
+
+DetectorWorker::~DetectorWorker()
+{
+    stop();
+}
+
+//==============================================================================
+void DetectorWorker::start(double sampleRate, int samplesPerBlock)
+{
+    const double blockMs = 1000.0 * juce::jmax(1, samplesPerBlock) / (sampleRate > 0.0 ? sampleRate : 44100.0);
+    pickUpMs_ = blockMs * pickUpShare_;
+
+    if (isThreadRunning())
+        return;
+
+    // An ordinary thread, even at the highest priority, can be kept waiting by the scheduler
+    // while the audio thread spins, so without real-time scheduling the blocks stay inline
+    const auto options = juce::Thread::RealtimeOptions{}.withApproximateAudioProcessingTime(juce::jmax(1, samplesPerBlock),
+                                                                                           sampleRate > 0.0 ? sampleRate : 44100.0);
+    isAvailable_.store(startRealtimeThread(options), std::memory_order_release);
+}
+
+void DetectorWorker::stop()
+{
+    // Blocks handed over from here on stay on the audio thread; one already pending is taken back by finishBlock()
+    isAvailable_.store(false, std::memory_order_release);
+
+    signalThreadShouldExit();
+    jobReady_.signal();
+    stopThread(1000);
+}
+
+void DetectorWorker::beginBlock(PitchDetector& detector, const float* audioData, int numSamples,
+                                const float* referenceData)
+{
+    // No helper: the block is simply processed here
+    if (!isAvailable_.load(std::memory_order_acquire))
+    {
+        detector.processAudioBlock(audioData, numSamples, referenceData);
+        return;
+    }
+
+    job_ = { &detector, audioData, numSamples, referenceData, juce::Time::getMillisecondCounterHiRes() + pickUpMs_ };
+    state_.store(JobState::pending, std::memory_order_release);
+    jobReady_.signal();
+}
+
+void DetectorWorker::finishBlock()
+{
+    for (;;)
+    {
+        auto state = state_.load(std::memory_order_acquire);
+
+        // Processed inline by beginBlock()
+        if (state == JobState::idle)
+            return;
+
+        if (state == JobState::finished)
+        {
+            state_.store(JobState::idle, std::memory_order_relaxed);
+            return;
+        }
+
+        // Not claimed in time, or the helper is going away: take the block back unless it's claimed meanwhile
+        if (state == JobState::pending
+            && (!isAvailable_.load(std::memory_order_acquire) || juce::Time::getMillisecondCounterHiRes() > job_.deadlineMs)
+            && state_.compare_exchange_strong(state, JobState::idle, std::memory_order_acquire))
+        {
+            job_.detector->processAudioBlock(job_.audioData, job_.numSamples, job_.referenceData);
+            numBlocksTakenBack_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        juce::Thread::yield();
+    }
+}
+
+//==============================================================================
+void DetectorWorker::run()
+{
+    while (!threadShouldExit())
+    {
+        jobReady_.wait();
+
+        // The audio thread may have taken the block back already (or this is stop()'s wake-up)
+        auto expected = JobState::pending;
+        if (!state_.compare_exchange_strong(expected, JobState::running, std::memory_order_acquire))
+            continue;
+
+        job_.detector->processAudioBlock(job_.audioData, job_.numSamples, job_.referenceData);
+        state_.store(JobState::finished, std::memory_order_release);
+    }
+}
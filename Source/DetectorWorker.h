@@ -0,0 +1,89 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "PitchDetector.h"
+#include <atomic>
+
+//==============================================================================
+/**
+ * Runs one PitchDetector's processAudioBlock() on a real-time helper thread
+ * while the audio thread analyses another channel.
+ *
+ * The audio thread hands over a block with beginBlock(), does its own work,
+ * then collects the result with finishBlock(). If the helper hasn't picked the
+ * block up by a deadline a fraction of a block after the hand-over, or has
+ * been stopped meanwhile, finishBlock() takes it back and processes it itself,
+ * so the audio thread never waits on a thread that may not run. Once the
+ * helper has started a block, finishBlock() spins (yielding) for the one
+ * processAudioBlock() left. Block data is read in place, so it must stay valid
+ * until finishBlock() returns. Without a real-time helper (not started, or the
+ * system refused one), beginBlock() processes the block itself.
+ */
+class DetectorWorker : private juce::Thread
+{
+public:
+    //==============================================================================
+    DetectorWorker();
+    ~DetectorWorker() override;
+
+    /**
+     * Starts the helper as a real-time thread (not real-time safe). Does nothing if it's already running.
+     *
+     * @param sampleRate      Audio sample rate in Hz
+     * @param samplesPerBlock Expected block size, which sets the pick-up deadline
+     */
+    void start(double sampleRate, int samplesPerBlock);
+
+    /** Stops the helper thread (not real-time safe). */
+    void stop();
+
+    /**
+     * Hands a block to the helper thread (audio thread).
+     *
+     * @param detector      Detector to run; not touched by the caller until finishBlock()
+     * @param audioData     Mono samples
+     * @param numSamples    Number of samples
+     * @param referenceData Accompaniment reference, or nullptr
+     */
+    void beginBlock(PitchDetector& detector, const float* audioData, int numSamples, const float* referenceData);
+
+    /** Waits for the block passed to beginBlock() to be processed, or processes it here (audio thread). */
+    void finishBlock();
+
+    /** Gets how many blocks the audio thread took back because the helper missed its deadline. Lock-free. */
+    int getNumBlocksTakenBack() const { return numBlocksTakenBack_.load(std::memory_order_relaxed); }
+
+private:
+    //==============================================================================
+    void run() override;
+
+    /** Where the block handed over by beginBlock() is. */
+    enum class JobState
+    {
+        idle,       ///< Nothing handed over (or already collected)
+        pending,    ///< Waiting for the helper; either thread may claim it
+        running,    ///< Claimed by the helper
+        finished    ///< Processed by the helper, waiting for finishBlock()
+    };
+
+    /** The block handed over by beginBlock(). */
+    struct Job
+    {
+        PitchDetector* detector = nullptr;
+        const float* audioData = nullptr;
+        int numSamples = 0;
+        const float* referenceData = nullptr;
+        double deadlineMs = 0.0;        ///< Time by which the helper must have claimed it
+    };
+
+    static constexpr double pickUpShare_ = 0.25;       ///< Share of a block's duration the helper has to claim it
+
+    Job job_;                                          ///< Written before state_ becomes pending
+    std::atomic<JobState> state_ { JobState::idle };   ///< Claimed by compare-and-swap, so a block runs once
+    std::atomic<bool> isAvailable_ { false };          ///< A real-time helper is running and accepting blocks
+    double pickUpMs_ = 0.0;                            ///< Longest the helper may take to claim a block
+    std::atomic<int> numBlocksTakenBack_ { 0 };        ///< Deadlines missed
+    juce::WaitableEvent jobReady_;                     ///< Wakes the helper for a new block
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DetectorWorker)
+};
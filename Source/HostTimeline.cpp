@@ -0,0 +1,69 @@
+#include "HostTimeline.h"
+#include <cmath>
+
+//==============================================================================
+void HostTimeline::prepare(double sampleRate, int latencySamples)
+{
+    sampleRate_ = sampleRate;
+    latencySamples_ = latencySamples;
+    isValid_ = false;
+}
+
+void HostTimeline::update(juce::AudioPlayHead* playHead, juce::int64 blockStartSample)
+{
+    isValid_ = false;
+    blockStartSample_ = blockStartSample;
+
+    if (playHead == nullptr)
+        return;
+
+    const auto position = playHead->getPosition();
+    if (!position.hasValue() || !position->getIsPlaying())
+        return;
+
+    const auto ppq = position->getPpqPosition();
+    if (!ppq.hasValue())
+        return;
+
+    ppq_ = *ppq;
+    bpm_ = position->getBpm().orFallback(120.0);
+    seconds_ = position->getTimeInSeconds().orFallback(ppq_ * 60.0 / bpm_);
+
+    const auto timeSignature = position->getTimeSignature().orFallback({});
+    barLengthPpq_ = timeSignature.numerator * 4.0 / juce::jmax(1, timeSignature.denominator);
+
+    // Prefer the host's bar bookkeeping; without it assume the signature never changed
+    const auto lastBarStart = position->getPpqPositionOfLastBarStart();
+    const auto barCount = position->getBarCount();
+
+    if (lastBarStart.hasValue() && barCount.hasValue())
+    {
+        lastBarStartPpq_ = *lastBarStart;
+        barCount_ = (int) *barCount;
+    }
+    else
+    {
+        barCount_ = (int) std::floor(ppq_ / barLengthPpq_);
+        lastBarStartPpq_ = barCount_ * barLengthPpq_;
+    }
+
+    isValid_ = true;
+}
+
+//==============================================================================
+HostTimeline::Position HostTimeline::getPosition(juce::int64 streamSample) const
+{
+    Position result;
+    if (!isValid_)
+        return result;
+
+    // Input was played against a timeline running latencySamples behind the play head
+    const double offsetSeconds = (double) (streamSample - blockStartSample_ - latencySamples_) / sampleRate_;
+
+    result.isValid = true;
+    result.bpm = bpm_;
+    result.seconds = seconds_ + offsetSeconds;
+    result.ppq = ppq_ + offsetSeconds * bpm_ / 60.0;
+    result.bar = barCount_ + (int) std::floor((result.ppq - lastBarStartPpq_) / barLengthPpq_);
+    return result;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+//==============================================================================
+/**
+ * Maps detector stream positions to the host's timeline.
+ *
+ * Once per block the audio thread takes a snapshot of the AudioPlayHead; any
+ * stream position near that block can then be converted to PPQ, seconds and bar
+ * by extrapolating at the block's tempo. Positions far from the snapshot assume
+ * the tempo didn't change in between.
+ *
+ * The host delays everything else by the latency we report so it lines up with
+ * our output, so audio arriving in a block whose play head reads P was played
+ * against P minus that latency; the conversion takes it off.
+ */
+class HostTimeline
+{
+public:
+    //==============================================================================
+    /** A stream position expressed on the host timeline. */
+    struct Position
+    {
+        bool isValid = false;           ///< False when the host gave no (running) timeline
+        double ppq = 0.0;               ///< Quarter notes since the start of the timeline
+        double seconds = 0.0;           ///< Seconds since the start of the timeline
+        double bpm = 120.0;             ///< Tempo at the snapshot
+        int bar = 0;                    ///< Bar index (0 = first bar)
+    };
+
+    HostTimeline() = default;
+
+    /**
+     * Prepares the timeline.
+     *
+     * @param sampleRate Audio sample rate in Hz
+     * @param latencySamples Latency the plugin reports to the host
+     */
+    void prepare(double sampleRate, int latencySamples);
+
+    /** Changes the latency taken off converted positions (audio thread). */
+    void setLatencySamples(int latencySamples) { latencySamples_ = latencySamples; }
+
+    /**
+     * Takes a snapshot of the play head for the block starting at blockStartSample (audio thread).
+     * The snapshot is invalid when there is no play head or the transport is stopped.
+     */
+    void update(juce::AudioPlayHead* playHead, juce::int64 blockStartSample);
+
+    /** Converts a detector stream position to the host timeline (audio thread). */
+    Position getPosition(juce::int64 streamSample) const;
+
+private:
+    //==============================================================================
+    double sampleRate_ = 44100.0;                             ///< Audio sample rate in Hz
+    int latencySamples_ = 0;                                  ///< Reported plugin latency
+
+    // Snapshot of the current block
+    bool isValid_ = false;                                    ///< Play head present and playing
+    juce::int64 blockStartSample_ = 0;                        ///< Stream position of the snapshot
+    double ppq_ = 0.0;                                        ///< PPQ at the block start
+    double seconds_ = 0.0;                                    ///< Seconds at the block start
+    double bpm_ = 120.0;                                      ///< Tempo
+    double lastBarStartPpq_ = 0.0;                            ///< PPQ of the bar containing the block start
+    int barCount_ = 0;                                        ///< Index of that bar
+    double barLengthPpq_ = 4.0;                               ///< From the time signature
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HostTimeline)
+};
@@ -0,0 +1,168 @@
+#include "KeyEstimator.h"
+#include <cmath>
+#include <cstring>
+
+//==============================================================================
+juce::String KeyEstimator::Estimate::getName() const
+{
+    if (!isValid())
+        return {};
+
+    return juce::String(CompileTimeTables::noteNames[static_cast<size_t>(key % 12)])
+           + (key < 12 ? " Major" : " Minor");
+}
+
+//==============================================================================
+void KeyEstimator::prepare(double sampleRate)
+{
+    sampleRate_ = sampleRate > 0.0 ? sampleRate : 44100.0;
+    reset();
+}
+
+void KeyEstimator::reset()
+{
+    histogram_.fill(0.0);
+    scores_.fill(0.0);
+    lastUpdateSample_ = 0;
+    published_.store(0, std::memory_order_release);
+}
+
+void KeyEstimator::addNote(const NoteEvent& event)
+{
+    if (event.midiNoteNumber < 0 || event.isSounding() || event.isCancelled())
+        return;
+
+    decayTo(event.offsetSample);
+    addWeight(event.midiNoteNumber % 12, getNoteWeight(event, sampleRate_));
+    publish();
+}
+
+void KeyEstimator::addChroma(const std::array<float, 12>& chroma, juce::int64 frameEndSample)
+{
+    decayTo(frameEndSample);
+
+    bool hasEnergy = false;
+    for (int pitchClass = 0; pitchClass < 12; ++pitchClass)
+    {
+        if (chroma[static_cast<size_t>(pitchClass)] > 0.0f)
+        {
+            addWeight(pitchClass, (double) chroma[static_cast<size_t>(pitchClass)]);
+            hasEnergy = true;
+        }
+    }
+
+    if (hasEnergy)
+        publish();
+}
+
+void KeyEstimator::decayTo(juce::int64 streamSample)
+{
+    // Histogram and scores scale alike
+    if (streamSample <= lastUpdateSample_)
+        return;
+
+    const double elapsedSeconds = (double) (streamSample - lastUpdateSample_) / sampleRate_;
+    const double decay = std::exp2(-elapsedSeconds / halfLifeSeconds_.load(std::memory_order_relaxed));
+
+    for (auto& weight : histogram_)
+        weight *= decay;
+
+    for (auto& score : scores_)
+        score *= decay;
+
+    lastUpdateSample_ = streamSample;
+}
+
+void KeyEstimator::addWeight(int pitchClass, double weight)
+{
+    histogram_[static_cast<size_t>(pitchClass)] += weight;
+
+    for (int key = 0; key < CompileTimeTables::numKeys; ++key)
+        scores_[static_cast<size_t>(key)] += weight * CompileTimeTables::keyProfileMatrix[static_cast<size_t>(key)][static_cast<size_t>(pitchClass)];
+}
+
+KeyEstimator::Estimate KeyEstimator::getEstimate() const
+{
+    const auto packed = published_.load(std::memory_order_acquire);
+
+    Estimate result;
+    result.key = (int) (packed >> 32) - 1;
+
+    const auto confidenceBits = (juce::uint32) (packed & 0xffffffff);
+    std::memcpy(&result.confidence, &confidenceBits, sizeof(float));
+    return result;
+}
+
+void KeyEstimator::publish()
+{
+    const auto result = pickBestKey(scores_, histogram_);
+
+    juce::uint32 confidenceBits;
+    std::memcpy(&confidenceBits, &result.confidence, sizeof(float));
+
+    published_.store(((juce::uint64) (juce::uint32) (result.key + 1) << 32) | confidenceBits,
+                     std::memory_order_release);
+}
+
+//==============================================================================
+KeyEstimator::Estimate KeyEstimator::estimate(const std::array<double, 12>& histogram)
+{
+    std::array<double, CompileTimeTables::numKeys> scores {};
+
+    for (int key = 0; key < CompileTimeTables::numKeys; ++key)
+        for (int pitchClass = 0; pitchClass < 12; ++pitchClass)
+            scores[static_cast<size_t>(key)] += histogram[static_cast<size_t>(pitchClass)]
+                                                * CompileTimeTables::keyProfileMatrix[static_cast<size_t>(key)][static_cast<size_t>(pitchClass)];
+
+    return pickBestKey(scores, histogram);
+}
+
+float KeyEstimator::getCorrelation(const std::array<double, 12>& histogram, int key)
+{
+    const double spread = getSpread(histogram);
+    if (key < 0 || key >= CompileTimeTables::numKeys || spread <= 0.0)
+        return 0.0f;
+
+    double score = 0.0;
+    for (int pitchClass = 0; pitchClass < 12; ++pitchClass)
+        score += histogram[static_cast<size_t>(pitchClass)]
+                 * CompileTimeTables::keyProfileMatrix[static_cast<size_t>(key)][static_cast<size_t>(pitchClass)];
+
+    return (float) juce::jlimit(-1.0, 1.0, score / spread);
+}
+
+double KeyEstimator::getNoteWeight(const NoteEvent& event, double sampleRate)
+{
+    return (double) event.getDuration() / sampleRate * (double) event.peakVelocity / 127.0;
+}
+
+double KeyEstimator::getSpread(const std::array<double, 12>& histogram)
+{
+    double sum = 0.0, sumOfSquares = 0.0;
+    for (double weight : histogram)
+    {
+        sum += weight;
+        sumOfSquares += weight * weight;
+    }
+
+    return std::sqrt(juce::jmax(0.0, sumOfSquares - sum * sum / 12.0));
+}
+
+KeyEstimator::Estimate KeyEstimator::pickBestKey(const std::array<double, CompileTimeTables::numKeys>& scores,
+                                                 const std::array<double, 12>& histogram)
+{
+    // The histogram's spread turns the best score back into a correlation
+    const double spread = getSpread(histogram);
+
+    Estimate result;
+    if (spread <= 0.0)
+        return result;
+
+    result.key = 0;
+    for (int key = 1; key < CompileTimeTables::numKeys; ++key)
+        if (scores[static_cast<size_t>(key)] > scores[static_cast<size_t>(result.key)])
+            result.key = key;
+
+    result.confidence = (float) juce::jlimit(-1.0, 1.0, scores[static_cast<size_t>(result.key)] / spread);
+    return result;
+}
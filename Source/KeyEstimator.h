@@ -0,0 +1,111 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "CompileTimeTables.h"
+#include "NoteEvent.h"
+#include <array>
+#include <atomic>
+
+//==============================================================================
+/**
+ * Live estimate of the musical key from the notes being played.
+ *
+ * Each finished note adds its duration times its velocity to a pitch-class
+ * histogram that decays exponentially with time, so the estimate follows the
+ * music rather than everything played since the plugin loaded. Alternatively
+ * the histogram can be fed whole-spectrum chroma frames, which also hear
+ * chords and accompaniment that the monophonic note track misses. The 24 key
+ * scores (dot products with CompileTimeTables::keyProfileMatrix, i.e. scaled
+ * Krumhansl-Schmuckler correlations) are kept up to date incrementally: a note
+ * touches one histogram bin and one matrix column, and decay scales
+ * everything by the same factor. Nothing is rescanned.
+ *
+ * addNote() runs on the audio thread; the result is published in a single
+ * atomic word and can be read from any thread.
+ */
+class KeyEstimator
+{
+public:
+    //==============================================================================
+    /** A key and how well the notes fit it. */
+    struct Estimate
+    {
+        int key = -1;                   ///< 0-11 = C..B major, 12-23 = C..B minor, -1 = no notes yet
+        float confidence = 0.0f;        ///< Correlation with the key's profile (-1 to 1)
+
+        /** Checks if there is an estimate. */
+        bool isValid() const { return key >= 0; }
+
+        /** Gets the key's name, e.g. "A Minor" (empty if there is no estimate). */
+        juce::String getName() const;
+    };
+
+    KeyEstimator() = default;
+
+    /**
+     * Prepares the estimator and forgets the histogram.
+     *
+     * @param sampleRate Sample rate event positions are counted at
+     */
+    void prepare(double sampleRate);
+
+    /** Forgets all notes. */
+    void reset();
+
+    /** Sets how long it takes a note's weight to halve. Thread-safe. */
+    void setHalfLife(double seconds) { halfLifeSeconds_.store(juce::jmax(0.1, seconds), std::memory_order_relaxed); }
+
+    /** Adds a finished note, positioned in detector stream samples (audio thread). */
+    void addNote(const NoteEvent& event);
+
+    /**
+     * Adds one analysis frame's spectral magnitude per pitch class (audio thread).
+     * Don't mix with addNote() without a reset() in between; the weights are in
+     * different units.
+     *
+     * @param chroma         Magnitude per pitch class, C = 0
+     * @param frameEndSample Detector stream position the frame ends at
+     */
+    void addChroma(const std::array<float, 12>& chroma, juce::int64 frameEndSample);
+
+    /** Gets the latest estimate. Lock-free; any thread. */
+    Estimate getEstimate() const;
+
+    //==============================================================================
+    /** Finds the best key for a pitch-class histogram (no decay involved). */
+    static Estimate estimate(const std::array<double, 12>& histogram);
+
+    /** Gets how well a pitch-class histogram fits a key (correlation, -1 to 1). */
+    static float getCorrelation(const std::array<double, 12>& histogram, int key);
+
+    /** Gets a note's histogram weight: duration in seconds times velocity (0-1). */
+    static double getNoteWeight(const NoteEvent& event, double sampleRate);
+
+private:
+    //==============================================================================
+    /** Decays the histogram and scores to a stream position. */
+    void decayTo(juce::int64 streamSample);
+
+    /** Adds weight to one pitch class: one bin, one matrix column. */
+    void addWeight(int pitchClass, double weight);
+
+    /** Picks the best score and publishes it with its correlation. */
+    void publish();
+
+    /** Gets the histogram's spread: the length of its mean-removed vector. */
+    static double getSpread(const std::array<double, 12>& histogram);
+
+    /** Picks the best of 24 key scores for a histogram. */
+    static Estimate pickBestKey(const std::array<double, CompileTimeTables::numKeys>& scores,
+                                const std::array<double, 12>& histogram);
+
+    double sampleRate_ = 44100.0;                             ///< For durations and decay
+    std::array<double, 12> histogram_ {};                     ///< Decayed weight per pitch class
+    std::array<double, CompileTimeTables::numKeys> scores_ {}; ///< Histogram . profile row, per key
+    juce::int64 lastUpdateSample_ = 0;                        ///< Time the decay was last applied at
+
+    std::atomic<double> halfLifeSeconds_{ 20.0 };             ///< Decay rate
+    std::atomic<juce::uint64> published_{ 0 };                ///< Key + 1 (high word), confidence bits (low word)
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(KeyEstimator)
+};
@@ -0,0 +1,155 @@
+#include "KeyTimeline.h"
+#include <juce_events/juce_events.h>
+#include <algorithm>
+
+//==============================================================================
+KeyTimeline::Analysis KeyTimeline::analyze(const RecordingStore& recording, double sampleRate,
+                                           const Settings& settings)
+{
+    constexpr int numKeys = CompileTimeTables::numKeys;
+    const auto numNotes = (size_t) recording.getNumEvents();
+
+    Analysis analysis;
+    auto& regions = analysis.regions;
+    if (numNotes == 0)
+        return analysis;
+
+    if (sampleRate <= 0.0)
+        sampleRate = 44100.0;
+
+    // The only walk over the recording (spilled notes come back from disk): each note's
+    // region-relevant fields are kept, so the regions are built from memory afterwards
+    struct NoteSummary
+    {
+        juce::int64 onsetSample = 0;
+        juce::int64 offsetSample = 0;
+        double onsetPpq = 0.0;
+        int bar = 0;
+        float weight = 0.0f;
+        juce::uint8 pitchClass = 0;
+        bool hasHostTime = false;
+    };
+
+    // Forward pass: best[k] = best score of the notes so far with the last one in key k.
+    // Staying in k adds the note's profile score; switching starts from the best key minus the penalty
+    std::array<double, numKeys> best {};
+    std::vector<NoteSummary> notes(numNotes);
+    std::vector<juce::uint32> stayedInKey(numNotes);          // Bit k: best[k] continued a region in k
+    std::vector<juce::uint8> previousBestKey(numNotes);       // Key a switch at this note came from
+    std::array<double, 12> totalWeights {};                   // Whole-take histogram, for the overall key
+    size_t index = 0;
+
+    recording.forEachEvent([&](const NoteEvent& event)
+    {
+        if (index == numNotes)
+            return;
+
+        const auto pitchClass = static_cast<size_t>(event.midiNoteNumber % 12);
+        const double weight = KeyEstimator::getNoteWeight(event, sampleRate);
+        totalWeights[pitchClass] += weight;
+
+        auto& note = notes[index];
+        note.onsetSample = event.onsetSample;
+        note.offsetSample = event.offsetSample;
+        note.onsetPpq = event.onsetPpq;
+        note.bar = event.bar;
+        note.weight = (float) weight;
+        note.pitchClass = (juce::uint8) pitchClass;
+        note.hasHostTime = event.hasHostTime;
+
+        int bestKey = 0;
+        for (int key = 1; key < numKeys; ++key)
+            if (best[static_cast<size_t>(key)] > best[static_cast<size_t>(bestKey)])
+                bestKey = key;
+
+        const double switchScore = best[static_cast<size_t>(bestKey)] - settings.changePenalty;
+        juce::uint32 stayMask = 0;
+
+        for (int key = 0; key < numKeys; ++key)
+        {
+            auto& score = best[static_cast<size_t>(key)];
+
+            if (index == 0 || score >= switchScore)
+                stayMask |= 1u << key;
+            else
+                score = switchScore;
+
+            score += weight * CompileTimeTables::keyProfileMatrix[static_cast<size_t>(key)][pitchClass];
+        }
+
+        stayedInKey[index] = stayMask;
+        previousBestKey[index] = (juce::uint8) bestKey;
+        ++index;
+    });
+
+    if (index == 0)
+        return analysis;
+
+    analysis.key = KeyEstimator::estimate(totalWeights);
+
+    // Backtrack: the key of every note, recorded only where it changes
+    std::vector<std::pair<size_t, int>> regionStarts;   // (first note, key), last region first
+    int key = 0;
+    for (int k = 1; k < numKeys; ++k)
+        if (best[static_cast<size_t>(k)] > best[static_cast<size_t>(key)])
+            key = k;
+
+    for (size_t i = index; i-- > 0;)
+    {
+        if (i == 0 || (stayedInKey[i] & (1u << key)) == 0)
+        {
+            regionStarts.emplace_back(i, key);
+            key = previousBestKey[i];
+        }
+    }
+
+    std::reverse(regionStarts.begin(), regionStarts.end());
+
+    // Region extents and how well each region's notes fit its key
+    regions.resize(regionStarts.size());
+
+    for (size_t r = 0; r < regionStarts.size(); ++r)
+    {
+        const auto first = regionStarts[r].first;
+        const auto end = r + 1 < regionStarts.size() ? regionStarts[r + 1].first : index;
+        const auto& start = notes[first];
+
+        auto& current = regions[r];
+        current.key = regionStarts[r].second;
+        current.startSample = start.onsetSample;
+        current.hasHostTime = start.hasHostTime;
+        current.startPpq = start.onsetPpq;
+        current.startBar = start.bar;
+        current.numNotes = (juce::int64) (end - first);
+
+        std::array<double, 12> histogram {};
+
+        for (auto i = first; i < end; ++i)
+        {
+            current.endSample = juce::jmax(current.endSample, notes[i].offsetSample);
+            histogram[notes[i].pitchClass] += notes[i].weight;
+        }
+
+        current.confidence = KeyEstimator::getCorrelation(histogram, current.key);
+    }
+
+    return analysis;
+}
+
+void KeyTimeline::analyzeAsync(juce::ThreadPool& pool, RecordingHandle recording, double sampleRate,
+                               const Settings& settings, std::function<void(Analysis)> onFinished)
+{
+    pool.addJob([recording = std::move(recording), sampleRate, settings, onFinished = std::move(onFinished)]
+    {
+        auto analysis = analyze(*recording, sampleRate, settings);
+
+        // The pool's owner is going away; nobody is left to take the result
+        if (auto* job = juce::ThreadPoolJob::getCurrentThreadPoolJob(); job != nullptr && job->shouldExit())
+            return;
+
+        juce::MessageManager::callAsync([analysis = std::move(analysis), onFinished]() mutable
+        {
+            onFinished(std::move(analysis));
+        });
+    });
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "KeyEstimator.h"
+#include "RecordingStore.h"
+#include <functional>
+#include <vector>
+
+//==============================================================================
+/**
+ * Splits a finished recording into regions of one key each, so modulating
+ * songs get a key per section rather than one overall guess.
+ *
+ * Every note contributes its weight (duration times velocity) times the key
+ * profile entry of its pitch class to each key's running prefix sum, so the
+ * score of any run of notes in a key is a difference of two prefix sums. The
+ * best segmentation maximises the summed region scores minus a penalty per key
+ * change; because region scores are prefix-sum differences, that dynamic
+ * program reduces to one step per note over the 24 keys: O(n * 24) time. The
+ * recording is read once (spilled notes come back from disk); each note keeps
+ * its back-pointers and the few fields its region needs, about 40 bytes, so
+ * sessions of hundreds of thousands of notes take well under a second.
+ *
+ * Blocking, so long takes are best analysed with analyzeAsync(); never on
+ * the audio thread.
+ */
+class KeyTimeline
+{
+public:
+    //==============================================================================
+    /** How eagerly keys change. */
+    struct Settings
+    {
+        double changePenalty = 4.0;     ///< Score a new region must gain (in note weight: seconds at full velocity)
+    };
+
+    /** The keys found in a recording. */
+    struct Analysis
+    {
+        KeyEstimator::Estimate key;         ///< Key of the whole recording (invalid if there are no notes)
+        std::vector<KeyRegion> regions;     ///< Regions in time order, covering every note
+    };
+
+    /**
+     * Finds the key and key regions of a recording.
+     *
+     * @param recording Finished recording
+     * @param sampleRate Sample rate its positions are counted at
+     * @param settings Change penalty
+     * @return The overall key and the regions (both empty if there are no notes)
+     */
+    static Analysis analyze(const RecordingStore& recording, double sampleRate, const Settings& settings);
+
+    /**
+     * Analyses on a pool thread and delivers the result on the message thread.
+     * Nothing is delivered if the pool asks the job to exit, so the pool's owner
+     * can cancel outstanding work by removing its jobs before it is destroyed.
+     *
+     * @param pool Pool to run on, owned by whoever must outlive the job
+     * @param recording Finished recording (kept alive until the job finishes)
+     * @param sampleRate Sample rate its positions are counted at
+     * @param settings Change penalty
+     * @param onFinished Called on the message thread with the analysis
+     */
+    static void analyzeAsync(juce::ThreadPool& pool, RecordingHandle recording, double sampleRate,
+                             const Settings& settings, std::function<void(Analysis)> onFinished);
+};
@@ -0,0 +1,205 @@
+#include "LiveMidiOutput.h"
+#include "NoteSegmenter.h"
+
+//==============================================================================
+void LiveMidiOutput::prepare(double sampleRate, int latencySamples)
+{
+    sampleRate_ = sampleRate;
+    latencySamples_ = juce::jmax(0, latencySamples);
+    reset();
+}
+
+void LiveMidiOutput::reset()
+{
+    firstScheduled_ = 0;
+    numScheduled_ = 0;
+    soundingNote_ = -1;
+    zoneAnnounced_ = false;
+}
+
+void LiveMidiOutput::setChannelSlot(int slot, int numSlots)
+{
+    numSlots = juce::jlimit(1, mpeNumMemberChannels_, numSlots);
+    channelSlot_ = juce::jlimit(0, numSlots - 1, slot);
+    numMemberChannels_ = mpeNumMemberChannels_ / numSlots;
+    nextMemberChannel_ = 0;
+}
+
+void LiveMidiOutput::setExpressionThresholds(float pitchBendCents, int pressureSteps)
+{
+    pitchBendThresholdCents_.store(juce::jmax(0.0f, pitchBendCents), std::memory_order_relaxed);
+    pressureThreshold_.store(juce::jmax(1, pressureSteps), std::memory_order_relaxed);
+}
+
+void LiveMidiOutput::setMaxExpressionRate(double updatesPerSecond)
+{
+    minUpdateIntervalSeconds_.store(updatesPerSecond > 0.0 ? 1.0 / updatesPerSecond : 0.0,
+                                    std::memory_order_relaxed);
+}
+
+//==============================================================================
+void LiveMidiOutput::processBlock(const PitchDetector::FrameResult& frame, float level,
+                                  juce::int64 blockStartSample, int numSamples,
+                                  juce::MidiBuffer& midiMessages)
+{
+    if (numSamples <= 0)
+        return;
+
+    const bool newFrame = frame.frameIndex != lastFrameIndex_;
+    lastFrameIndex_ = frame.frameIndex;
+
+    const bool enabled = isEnabled();
+    const auto mode = getOutputMode();
+
+    if (!enabled || mode != activeMode_)
+    {
+        // Flush what is pending and release the sounding note in this block rather than leaving it hanging
+        emitDueMessages(blockStartSample, numSamples, true, midiMessages);
+
+        if (soundingNote_ >= 0)
+            midiMessages.addEvent(juce::MidiMessage::noteOff(soundingChannel_, soundingNote_), numSamples - 1);
+
+        reset();
+        activeMode_ = mode;
+
+        if (!enabled)
+            return;
+    }
+
+    // Announce the MPE lower zone (RPN 6) so receivers map member channels correctly
+    // (once for the whole zone, by the first of several outputs)
+    if (activeMode_ == OutputMode::mpe && !zoneAnnounced_)
+    {
+        if (channelSlot_ == 0)
+        {
+            midiMessages.addEvent(juce::MidiMessage::controllerEvent(mpeMasterChannel_, 101, 0), 0);
+            midiMessages.addEvent(juce::MidiMessage::controllerEvent(mpeMasterChannel_, 100, 6), 0);
+            midiMessages.addEvent(juce::MidiMessage::controllerEvent(mpeMasterChannel_, 6, mpeNumMemberChannels_), 0);
+        }
+
+        zoneAnnounced_ = true;
+    }
+
+    // A new result is placed at its frame end, as seen through the reported latency
+    if (newFrame)
+    {
+        const auto samplePosition = frame.frameEndSample + latencySamples_;
+
+        if (frame.midiNoteNumber != soundingNote_)
+            handleNoteChange(frame, level, samplePosition);
+        else if (activeMode_ == OutputMode::mpe && soundingNote_ >= 0)
+            handleExpression(frame, samplePosition);
+    }
+
+    emitDueMessages(blockStartSample, numSamples, false, midiMessages);
+}
+
+void LiveMidiOutput::handleNoteChange(const PitchDetector::FrameResult& frame, float level,
+                                      juce::int64 samplePosition)
+{
+    if (soundingNote_ >= 0)
+        schedule(samplePosition, juce::MidiMessage::noteOff(soundingChannel_, soundingNote_));
+
+    soundingNote_ = frame.midiNoteNumber;
+    if (soundingNote_ < 0)
+        return;
+
+    if (activeMode_ == OutputMode::mpe)
+    {
+        // Fresh member channel per note so a release tail is never bent by the next note
+        soundingChannel_ = mpeMasterChannel_ + 1 + channelSlot_ * numMemberChannels_ + nextMemberChannel_;
+        nextMemberChannel_ = (nextMemberChannel_ + 1) % numMemberChannels_;
+
+        // MPE wants the channel's expression set before its note-on
+        lastPitchBend_ = centsToPitchBend(frame.centsOffset);
+        lastPressure_ = magnitudeToPressure(frame.magnitude);
+        lastPitchBendSample_ = samplePosition;
+        lastPressureSample_ = samplePosition;
+
+        schedule(samplePosition, juce::MidiMessage::pitchWheel(soundingChannel_, lastPitchBend_));
+        schedule(samplePosition, juce::MidiMessage::channelPressureChange(soundingChannel_, lastPressure_));
+    }
+    else
+    {
+        soundingChannel_ = (midiChannel_.load(std::memory_order_relaxed) - 1 + channelSlot_) % 16 + 1;
+    }
+
+    schedule(samplePosition, juce::MidiMessage::noteOn(soundingChannel_, soundingNote_,
+                                                       NoteSegmenter::levelToVelocity(level)));
+}
+
+void LiveMidiOutput::handleExpression(const PitchDetector::FrameResult& frame, juce::int64 samplePosition)
+{
+    const auto minInterval = (juce::int64) (minUpdateIntervalSeconds_.load(std::memory_order_relaxed) * sampleRate_);
+
+    // Thin both streams: send only changes that matter, and no faster than the rate limit
+    const int bendThreshold = juce::jmax(1, juce::roundToInt(pitchBendThresholdCents_.load(std::memory_order_relaxed)
+                                                             * 8192.0f / mpePitchBendRangeCents_));
+    const int pitchBend = centsToPitchBend(frame.centsOffset);
+
+    if (std::abs(pitchBend - lastPitchBend_) >= bendThreshold
+        && samplePosition - lastPitchBendSample_ >= minInterval)
+    {
+        schedule(samplePosition, juce::MidiMessage::pitchWheel(soundingChannel_, pitchBend));
+        lastPitchBend_ = pitchBend;
+        lastPitchBendSample_ = samplePosition;
+    }
+
+    const int pressure = magnitudeToPressure(frame.magnitude);
+
+    if (std::abs(pressure - lastPressure_) >= pressureThreshold_.load(std::memory_order_relaxed)
+        && samplePosition - lastPressureSample_ >= minInterval)
+    {
+        schedule(samplePosition, juce::MidiMessage::channelPressureChange(soundingChannel_, pressure));
+        lastPressure_ = pressure;
+        lastPressureSample_ = samplePosition;
+    }
+}
+
+//==============================================================================
+void LiveMidiOutput::schedule(juce::int64 samplePosition, const juce::MidiMessage& message)
+{
+    if (numScheduled_ == maxScheduledMessages_ || message.getRawDataSize() > 3)
+    {
+        numDropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto& scheduled = scheduled_[static_cast<size_t>((firstScheduled_ + numScheduled_) % maxScheduledMessages_)];
+    scheduled.samplePosition = samplePosition;
+    scheduled.numBytes = (juce::uint8) message.getRawDataSize();
+    std::copy(message.getRawData(), message.getRawData() + scheduled.numBytes, scheduled.data);
+    ++numScheduled_;
+}
+
+void LiveMidiOutput::emitDueMessages(juce::int64 blockStartSample, int numSamples, bool flushAll,
+                                     juce::MidiBuffer& midiMessages)
+{
+    // Messages are in time order; late ones go at the block start, flushed ones at the latest at its end
+    while (numScheduled_ > 0)
+    {
+        const auto& message = scheduled_[static_cast<size_t>(firstScheduled_)];
+        if (!flushAll && message.samplePosition >= blockStartSample + numSamples)
+            break;
+
+        const int offset = (int) juce::jlimit((juce::int64) 0, (juce::int64) numSamples - 1,
+                                              message.samplePosition - blockStartSample);
+        midiMessages.addEvent(message.data, message.numBytes, offset);
+
+        firstScheduled_ = (firstScheduled_ + 1) % maxScheduledMessages_;
+        --numScheduled_;
+    }
+}
+
+//==============================================================================
+int LiveMidiOutput::centsToPitchBend(float cents)
+{
+    return juce::jlimit(0, 16383, 8192 + juce::roundToInt(cents * 8192.0f / mpePitchBendRangeCents_));
+}
+
+int LiveMidiOutput::magnitudeToPressure(float magnitude)
+{
+    // 0 dB = full-scale sine (Hann-windowed peak of 1/4); pressure falls linearly to 0 at -60 dB
+    const float decibels = 20.0f * std::log10(juce::jmax(magnitude * 4.0f, 1.0e-6f));
+    return juce::jlimit(0, 127, juce::roundToInt(127.0f * (1.0f + decibels / 60.0f)));
+}
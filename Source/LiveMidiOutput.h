@@ -0,0 +1,173 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "PitchDetector.h"
+#include <array>
+#include <atomic>
+
+//==============================================================================
+/**
+ * Writes detected notes to the plugin's MIDI output, sample-accurately.
+ *
+ * Each message is placed at the stream position where the detector's frame
+ * ended, shifted by the latency the plugin reports. Because results are
+ * published up to that latency after their frame ends, a message can be due in
+ * a later block; such messages wait in a small fixed-size schedule. Nothing on
+ * the audio thread allocates.
+ *
+ * In MPE mode every note gets its own member channel of an MPE lower zone and
+ * carries continuous pitch bend (from the frame's cents offset) and pressure
+ * (from its magnitude). Expression updates are thinned by a change threshold
+ * and a rate limit, so steady notes produce almost no traffic.
+ *
+ * One output follows one detector. When several detectors play at once (the
+ * channels of a stereo input, the strings of a divided pickup), each gets an
+ * output with its own channel slot: the next channel up in notes mode, its
+ * own block of member channels in MPE mode.
+ */
+class LiveMidiOutput
+{
+public:
+    //==============================================================================
+    /** What the output sends. */
+    enum class OutputMode
+    {
+        notes,      ///< Plain note-on/note-off on one channel
+        mpe         ///< MPE lower zone: per-note channel, pitch bend and pressure
+    };
+
+    LiveMidiOutput() = default;
+
+    /**
+     * Prepares the output.
+     *
+     * @param sampleRate Audio sample rate in Hz
+     * @param latencySamples Latency reported to the host; messages are delayed by this much
+     */
+    void prepare(double sampleRate, int latencySamples);
+
+    /** Changes the delay applied to messages scheduled from now on (audio thread). */
+    void setLatencySamples(int latencySamples) { latencySamples_ = juce::jmax(0, latencySamples); }
+
+    /** Drops scheduled messages and forgets the sounding note (no note-off is sent). */
+    void reset();
+
+    /**
+     * Adds the MIDI for one audio block (audio thread).
+     *
+     * @param frame Latest detector result
+     * @param level RMS level of the block, used for note-on velocity
+     * @param blockStartSample Detector stream position of the block's first sample
+     * @param numSamples Number of samples in the block
+     * @param midiMessages Host buffer to add messages to
+     */
+    void processBlock(const PitchDetector::FrameResult& frame, float level,
+                      juce::int64 blockStartSample, int numSamples,
+                      juce::MidiBuffer& midiMessages);
+
+    //==============================================================================
+    /** Enables or disables output; disabling releases the sounding note. Thread-safe. */
+    void setEnabled(bool shouldBeEnabled) { enabled_.store(shouldBeEnabled, std::memory_order_relaxed); }
+
+    /** Checks if output is enabled. */
+    bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    /** Sets the output mode; the sounding note is released on a change. Thread-safe. */
+    void setOutputMode(OutputMode mode) { outputMode_.store(mode, std::memory_order_relaxed); }
+
+    /** Gets the output mode. */
+    OutputMode getOutputMode() const { return outputMode_.load(std::memory_order_relaxed); }
+
+    /** Sets the MIDI channel (1-16) used in notes mode. Thread-safe. */
+    void setMidiChannel(int channel) { midiChannel_.store(juce::jlimit(1, 16, channel), std::memory_order_relaxed); }
+
+    /**
+     * Sets which of several outputs playing side by side this is (not while
+     * processing). Slot n sends on the MIDI channel n above the notes-mode
+     * channel, or on the n-th of numSlots equal blocks of MPE member channels;
+     * only slot 0 announces the MPE zone.
+     *
+     * @param slot Index of this output (0 to numSlots - 1)
+     * @param numSlots Number of outputs playing side by side
+     */
+    void setChannelSlot(int slot, int numSlots);
+
+    /**
+     * Sets how far expression must move before an update is sent (MPE mode). Thread-safe.
+     *
+     * @param pitchBendCents Minimum pitch change in cents
+     * @param pressureSteps Minimum pressure change (0-127 scale)
+     */
+    void setExpressionThresholds(float pitchBendCents, int pressureSteps);
+
+    /** Sets the maximum rate of pitch bend and of pressure updates per note (MPE mode). Thread-safe. */
+    void setMaxExpressionRate(double updatesPerSecond);
+
+    /** Gets the number of messages dropped because the schedule was full. */
+    int getNumDroppedMessages() const { return numDropped_.load(std::memory_order_relaxed); }
+
+private:
+    //==============================================================================
+    /** A short MIDI message waiting for its block. */
+    struct ScheduledMessage
+    {
+        juce::int64 samplePosition;     ///< Stream position the message belongs at
+        juce::uint8 data[3];            ///< Raw message bytes
+        juce::uint8 numBytes;           ///< 2 or 3
+    };
+
+    /** Releases the sounding note and schedules messages for a new result. */
+    void handleNoteChange(const PitchDetector::FrameResult& frame, float level, juce::int64 samplePosition);
+
+    /** Schedules thinned pitch bend and pressure updates for the sounding note (MPE). */
+    void handleExpression(const PitchDetector::FrameResult& frame, juce::int64 samplePosition);
+
+    /** Appends a message to the schedule (dropped if full). */
+    void schedule(juce::int64 samplePosition, const juce::MidiMessage& message);
+
+    /** Writes everything due within the block (or everything, if flushAll) into the host buffer. */
+    void emitDueMessages(juce::int64 blockStartSample, int numSamples, bool flushAll,
+                         juce::MidiBuffer& midiMessages);
+
+    /** Converts a cents offset to a 14-bit pitch bend value for the MPE bend range. */
+    static int centsToPitchBend(float cents);
+
+    /** Converts a spectral magnitude to 0-127 pressure (60 dB range). */
+    static int magnitudeToPressure(float magnitude);
+
+    static constexpr int maxScheduledMessages_ = 64;          ///< Schedule capacity
+    static constexpr int mpeMasterChannel_ = 1;               ///< Lower zone master channel
+    static constexpr int mpeNumMemberChannels_ = 15;          ///< Channels 2-16
+    static constexpr float mpePitchBendRangeCents_ = 4800.0f; ///< MPE default member bend range
+
+    std::array<ScheduledMessage, maxScheduledMessages_> scheduled_; ///< FIFO, in time order
+    int firstScheduled_ = 0;                                  ///< Index of the oldest message
+    int numScheduled_ = 0;                                    ///< Messages waiting
+
+    double sampleRate_ = 44100.0;                             ///< For the rate limit
+    int latencySamples_ = 0;                                  ///< Delay applied to every message
+    juce::uint32 lastFrameIndex_ = 0;                         ///< Last FrameResult consumed
+    OutputMode activeMode_ = OutputMode::notes;               ///< Mode the sounding note was sent in
+    int channelSlot_ = 0;                                     ///< Which of the outputs side by side this is
+    int numMemberChannels_ = mpeNumMemberChannels_;           ///< MPE member channels this output rotates through
+    bool zoneAnnounced_ = false;                              ///< MPE zone layout sent
+
+    // Sounding note
+    int soundingNote_ = -1;                                   ///< Note last switched on, or -1
+    int soundingChannel_ = 1;                                 ///< Channel it was sent on
+    int nextMemberChannel_ = 0;                               ///< Rotates through this output's MPE member channels
+    int lastPitchBend_ = 8192;                                ///< Last bend sent on soundingChannel_
+    int lastPressure_ = 0;                                    ///< Last pressure sent on soundingChannel_
+    juce::int64 lastPitchBendSample_ = 0;                     ///< When it was sent
+    juce::int64 lastPressureSample_ = 0;                      ///< When it was sent
+
+    std::atomic<bool> enabled_{ true };                       ///< Output switch
+    std::atomic<OutputMode> outputMode_{ OutputMode::notes }; ///< Requested mode
+    std::atomic<int> midiChannel_{ 1 };                       ///< Channel for notes mode
+    std::atomic<float> pitchBendThresholdCents_{ 3.0f };      ///< Minimum bend change
+    std::atomic<int> pressureThreshold_{ 4 };                 ///< Minimum pressure change
+    std::atomic<double> minUpdateIntervalSeconds_{ 0.02 };    ///< Rate limit per expression stream
+    std::atomic<int> numDropped_{ 0 };                        ///< Schedule overflow counter
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LiveMidiOutput)
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <vector>
+
+//==============================================================================
+/**
+ * Wait-free single-producer/single-consumer queue of fixed-size elements.
+ *
+ * Built on juce::AbstractFifo with storage allocated up front, so push() and
+ * pop() never allocate, lock or block. Exactly one thread may push and exactly
+ * one (other) thread may pop.
+ */
+template <typename ElementType>
+class LockFreeQueue
+{
+public:
+    //==============================================================================
+    /**
+     * Creates a queue. Not real-time safe.
+     *
+     * @param capacity Maximum number of queued elements
+     */
+    explicit LockFreeQueue(int capacity)
+        : fifo_(capacity + 1)  // +1 because JUCE AbstractFifo holds size-1 items
+        , storage_(static_cast<size_t>(capacity + 1))
+    {
+    }
+
+    /**
+     * Appends an element (producer thread only).
+     *
+     * @return false if the queue was full and the element was dropped
+     */
+    bool push(const ElementType& element)
+    {
+        int start1, size1, start2, size2;
+        fifo_.prepareToWrite(1, start1, size1, start2, size2);
+
+        if (size1 == 0)
+        {
+            numDropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        storage_[static_cast<size_t>(start1)] = element;
+        fifo_.finishedWrite(1);
+        return true;
+    }
+
+    /**
+     * Removes the oldest element (consumer thread only).
+     *
+     * @return false if the queue was empty
+     */
+    bool pop(ElementType& element)
+    {
+        int start1, size1, start2, size2;
+        fifo_.prepareToRead(1, start1, size1, start2, size2);
+
+        if (size1 == 0)
+            return false;
+
+        element = storage_[static_cast<size_t>(start1)];
+        fifo_.finishedRead(1);
+        return true;
+    }
+
+    /** Gets the number of elements waiting to be popped. */
+    int getNumReady() const { return fifo_.getNumReady(); }
+
+    /** Gets the number of elements dropped because the queue was full. */
+    int getNumDropped() const { return numDropped_.load(std::memory_order_relaxed); }
+
+private:
+    //==============================================================================
+    juce::AbstractFifo fifo_;                                 ///< Read/write positions
+    std::vector<ElementType> storage_;                        ///< Element slots
+    std::atomic<int> numDropped_{ 0 };                        ///< Overflow counter
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LockFreeQueue)
+};
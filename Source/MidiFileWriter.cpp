@@ -0,0 +1,240 @@
+#include "MidiFileWriter.h"
+#include "ChordRecognizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+//==============================================================================
+MidiFileWriter::MidiFileWriter(const juce::File& file, double sampleRate, const Options& options)
+    : file_(file)
+    , options_(options)
+    , sampleRate_(sampleRate > 0.0 ? sampleRate : 44100.0)
+{
+    options_.ticksPerQuarterNote = juce::jlimit(24, 0x7fff, options_.ticksPerQuarterNote);
+    options_.midiChannel = juce::jlimit(1, 16, options_.midiChannel);
+
+    for (auto& bend : lastPitchBend_)
+        bend = 8192;
+
+    file_.deleteFile();
+    stream_ = std::make_unique<juce::FileOutputStream>(file_);
+
+    if (stream_->failedToOpen())
+    {
+        stream_.reset();
+        return;
+    }
+
+    // Header: format 0, one track, ticks per quarter note
+    stream_->write("MThd", 4);
+    stream_->writeIntBigEndian(6);
+    stream_->writeShortBigEndian(0);
+    stream_->writeShortBigEndian(1);
+    stream_->writeShortBigEndian((short) options_.ticksPerQuarterNote);
+
+    stream_->write("MTrk", 4);
+    trackLengthPosition_ = stream_->getPosition();
+    stream_->writeIntBigEndian(0);
+    trackStartPosition_ = stream_->getPosition();
+}
+
+MidiFileWriter::~MidiFileWriter()
+{
+    finish();
+}
+
+//==============================================================================
+void MidiFileWriter::writeNote(const NoteEvent& event)
+{
+    if (stream_ == nullptr || event.midiNoteNumber < 0 || event.isSounding())
+        return;
+
+    // The file's tempo starts at the first note's (and follows the host's after that)
+    const double noteBpm = event.hasHostTime ? (double) event.bpm : (bpm_ > 0.0 ? bpm_ : 120.0);
+    if (noteBpm > 0.0 && noteBpm != bpm_)
+    {
+        const double tempoTick = bpm_ > 0.0 ? toTicks(event, false) : 0.0;
+        writePendingEvents(tempoTick);
+        writeTempo(tempoTick, noteBpm);
+        bpm_ = noteBpm;
+    }
+
+    const double onsetTick = toTicks(event, false);
+    const double offsetTick = toTicks(event, true);
+
+    writePendingEvents(onsetTick);
+
+    const int channel = getChannelIndex(event);
+    const auto status = [channel](int type) { return (juce::uint8) (type | channel); };
+
+    // A repeat of a note still held on the channel ends it first, so the note-on isn't swallowed
+    for (auto it = pendingNoteOffs_.begin(); it != pendingNoteOffs_.end(); ++it)
+    {
+        if (it->status == status(0x80) && it->midiNoteNumber == (juce::uint8) event.midiNoteNumber)
+        {
+            const juce::uint8 noteOff[] = { it->status, it->midiNoteNumber, 0 };
+            writeEvent(onsetTick, noteOff, 3);
+            pendingNoteOffs_.erase(it);
+            break;
+        }
+    }
+
+    if (options_.includePitchBend)
+    {
+        const int pitchBend = juce::jlimit(0, 16383, 8192 + juce::roundToInt(event.centsOffset * 8192.0f / 200.0f));
+
+        if (pitchBend != lastPitchBend_[channel])
+        {
+            const juce::uint8 bend[] = { status(0xe0), (juce::uint8) (pitchBend & 127), (juce::uint8) (pitchBend >> 7) };
+            writeEvent(onsetTick, bend, 3);
+            lastPitchBend_[channel] = pitchBend;
+        }
+    }
+
+    const juce::uint8 noteOn[] = { status(0x90), (juce::uint8) event.midiNoteNumber, juce::jmax((juce::uint8) 1, event.peakVelocity) };
+    writeEvent(onsetTick, noteOn, 3);
+
+    // The note-off waits until later notes (or finish()) pass it, with the chords that change meanwhile
+    const PendingNoteOff noteOff { juce::jmax(offsetTick, onsetTick + 1.0), status(0x80), (juce::uint8) event.midiNoteNumber };
+    const auto position = std::upper_bound(pendingNoteOffs_.begin(), pendingNoteOffs_.end(), noteOff,
+                                           [](const PendingNoteOff& a, const PendingNoteOff& b) { return a.tick < b.tick; });
+    pendingNoteOffs_.insert(position, noteOff);
+
+    anchorSample_ = event.onsetSample;
+    anchorTick_ = onsetTick;
+    ++numNotes_;
+}
+
+void MidiFileWriter::writeChord(const ChordEvent& event)
+{
+    if (stream_ != nullptr)
+        pendingChords_.push_back(event);
+}
+
+bool MidiFileWriter::finish()
+{
+    if (stream_ == nullptr)
+        return false;
+
+    if (bpm_ <= 0.0)
+        writeTempo(0.0, 120.0);
+
+    writePendingEvents(std::numeric_limits<double>::max());
+
+    const juce::uint8 endOfTrack[] = { 0xff, 0x2f, 0x00 };
+    writeEvent((double) lastTick_, endOfTrack, 3);
+
+    const auto trackLength = stream_->getPosition() - trackStartPosition_;
+    const bool ok = stream_->setPosition(trackLengthPosition_)
+                    && stream_->writeIntBigEndian((int) trackLength);
+
+    stream_->flush();
+    stream_.reset();
+    return ok;
+}
+
+//==============================================================================
+double MidiFileWriter::toTicks(const NoteEvent& event, bool offset) const
+{
+    return offset ? toTicks(event.offsetSample, event.offsetPpq, event.hasHostTime)
+                  : toTicks(event.onsetSample, event.onsetPpq, event.hasHostTime);
+}
+
+double MidiFileWriter::toTicks(juce::int64 sample, double ppq, bool hasHostTime) const
+{
+    const double ticksPerQuarterNote = (double) options_.ticksPerQuarterNote;
+
+    if (hasHostTime)
+        return juce::jmax(0.0, ppq * ticksPerQuarterNote);
+
+    const double seconds = (double) (sample - anchorSample_) / sampleRate_;
+    return anchorTick_ + seconds * (bpm_ > 0.0 ? bpm_ : 120.0) / 60.0 * ticksPerQuarterNote;
+}
+
+void MidiFileWriter::writePendingEvents(double tick)
+{
+    // Both lists are in time order, so the events due are at their fronts; a chord
+    // marker goes before a note-off at the same tick
+    size_t numChords = 0;
+    size_t numNoteOffs = 0;
+
+    for (;;)
+    {
+        const double chordTick = numChords < pendingChords_.size()
+                                     ? toTicks(pendingChords_[numChords].onsetSample,
+                                               pendingChords_[numChords].onsetPpq,
+                                               pendingChords_[numChords].hasHostTime)
+                                     : std::numeric_limits<double>::max();
+        const double noteOffTick = numNoteOffs < pendingNoteOffs_.size()
+                                       ? pendingNoteOffs_[numNoteOffs].tick
+                                       : std::numeric_limits<double>::max();
+
+        if (juce::jmin(chordTick, noteOffTick) > tick
+            || (numChords == pendingChords_.size() && numNoteOffs == pendingNoteOffs_.size()))
+            break;
+
+        if (chordTick <= noteOffTick)
+        {
+            const auto& chord = pendingChords_[numChords++];
+            const DetectedChord detected { chord.root, chord.quality, chord.confidence };
+            writeText(chordTick, 0x06, detected.isValid() ? detected.getName() : juce::String("N.C."));
+        }
+        else
+        {
+            const auto& pending = pendingNoteOffs_[numNoteOffs++];
+            const juce::uint8 noteOff[] = { pending.status, pending.midiNoteNumber, 0 };
+            writeEvent(noteOffTick, noteOff, 3);
+        }
+    }
+
+    pendingChords_.erase(pendingChords_.begin(), pendingChords_.begin() + (std::ptrdiff_t) numChords);
+    pendingNoteOffs_.erase(pendingNoteOffs_.begin(), pendingNoteOffs_.begin() + (std::ptrdiff_t) numNoteOffs);
+}
+
+void MidiFileWriter::writeText(double tick, int type, const juce::String& text)
+{
+    const auto utf8 = text.toRawUTF8();
+    const auto numBytes = juce::jmin((int) std::strlen(utf8), 0x7f);
+    const juce::uint8 header[] = { 0xff, (juce::uint8) type, (juce::uint8) numBytes };
+
+    writeEvent(tick, header, 3);
+    stream_->write(utf8, (size_t) numBytes);
+}
+
+void MidiFileWriter::writeEvent(double tick, const juce::uint8* data, int numBytes)
+{
+    const auto eventTick = juce::jmax(lastTick_, (juce::int64) std::llround(tick));
+
+    writeVariableLength((juce::uint32) juce::jmin(eventTick - lastTick_, (juce::int64) 0x0fffffff));
+    stream_->write(data, (size_t) numBytes);
+    lastTick_ = eventTick;
+}
+
+void MidiFileWriter::writeTempo(double tick, double bpm)
+{
+    const auto microsecondsPerQuarter = (juce::uint32) juce::jlimit(1.0, (double) 0xffffff, std::round(60.0e6 / bpm));
+    const juce::uint8 tempo[] = { 0xff, 0x51, 0x03,
+                                  (juce::uint8) (microsecondsPerQuarter >> 16),
+                                  (juce::uint8) (microsecondsPerQuarter >> 8),
+                                  (juce::uint8) microsecondsPerQuarter };
+    writeEvent(tick, tempo, 6);
+}
+
+void MidiFileWriter::writeVariableLength(juce::uint32 value)
+{
+    // Seven bits per byte, most significant first, continuation bit on all but the last
+    juce::uint8 bytes[4];
+    int numBytes = 0;
+
+    do
+    {
+        bytes[numBytes++] = (juce::uint8) (value & 0x7f);
+        value >>= 7;
+    } while (value != 0);
+
+    while (--numBytes > 0)
+        stream_->writeByte((char) (bytes[numBytes] | 0x80));
+
+    stream_->writeByte((char) bytes[0]);
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "ChordEvent.h"
+#include "NoteEvent.h"
+#include <vector>
+
+//==============================================================================
+/**
+ * Streams finished notes into a Standard MIDI File (format 0, one track).
+ *
+ * Notes are written as they arrive, so the file grows with the session and
+ * nothing but a few bytes of state is held in memory. The track length in the
+ * header is patched in by finish().
+ *
+ * Notes that carry host time are placed at their PPQ position, so the file
+ * lines up with the DAW timeline when imported at its start; tempo changes
+ * become tempo meta events. Notes without host time continue from the last
+ * placed note at the current tempo (120 BPM if the host never gave one).
+ *
+ * Chord changes become marker meta events. A chord is usually reported
+ * while the note it sits under is still sounding, so markers wait until a
+ * later note (or finish()) reaches their position; that keeps every event in
+ * time order without buffering notes. Note-offs wait the same way, because
+ * notes from different sources (input channels or strings) overlap. Each
+ * source gets its own channel, counting up from Options::midiChannel.
+ *
+ * Expects finished notes in onset order, as the recorder produces them.
+ */
+class MidiFileWriter
+{
+public:
+    //==============================================================================
+    /** What goes into the file. */
+    struct Options
+    {
+        int ticksPerQuarterNote = 960;  ///< Timing resolution
+        int midiChannel = 1;            ///< Channel (1-16) of the first source; further sources take the next ones
+        bool includePitchBend = false;  ///< Bend each note by its average pitch deviation (+/-2 semitone range)
+    };
+
+    /**
+     * Creates the file (replacing any existing one) and writes the header.
+     *
+     * @param file Destination
+     * @param sampleRate Sample rate the event positions were counted at
+     * @param options Resolution, channel and pitch bend
+     */
+    MidiFileWriter(const juce::File& file, double sampleRate, const Options& options);
+    ~MidiFileWriter();
+
+    /** Checks if the file could be created. */
+    bool openedOk() const { return stream_ != nullptr; }
+
+    /** Appends a finished note (note-on, note-off and, optionally, pitch bend). */
+    void writeNote(const NoteEvent& event);
+
+    /** Queues a chord change marker, written once the notes reach its position. */
+    void writeChord(const ChordEvent& event);
+
+    /**
+     * Ends the track and patches its length. Further notes are ignored.
+     *
+     * @return true if the complete file was written
+     */
+    bool finish();
+
+    //==============================================================================
+    /** Gets the destination file. */
+    const juce::File& getFile() const { return file_; }
+
+    /** Gets the number of notes written. */
+    juce::int64 getNumNotesWritten() const { return numNotes_; }
+
+private:
+    //==============================================================================
+    /** Converts a note's onset or offset to ticks. */
+    double toTicks(const NoteEvent& event, bool offset) const;
+
+    /** Converts a position to ticks: its PPQ if it has host time, else relative to the anchor note. */
+    double toTicks(juce::int64 sample, double ppq, bool hasHostTime) const;
+
+    /** A note-off waiting for earlier events from other sources to be written. */
+    struct PendingNoteOff
+    {
+        double tick = 0.0;                                    ///< When the note ends
+        juce::uint8 status = 0x80;                            ///< Note-off on the note's channel
+        juce::uint8 midiNoteNumber = 0;                       ///< Note to end
+    };
+
+    /** Gets the channel (0-15) a note's source plays on. */
+    int getChannelIndex(const NoteEvent& event) const { return (options_.midiChannel - 1 + event.getSourceSlot()) % 16; }
+
+    /** Writes the queued note-offs and chord markers at or before a tick, in time order. */
+    void writePendingEvents(double tick);
+
+    /** Writes a text meta event. */
+    void writeText(double tick, int type, const juce::String& text);
+
+    /** Writes one track event at a tick (clamped so time never runs backwards). */
+    void writeEvent(double tick, const juce::uint8* data, int numBytes);
+
+    /** Writes a tempo meta event. */
+    void writeTempo(double tick, double bpm);
+
+    /** Writes a delta time as a variable-length quantity. */
+    void writeVariableLength(juce::uint32 value);
+
+    juce::File file_;                                         ///< Destination
+    std::unique_ptr<juce::FileOutputStream> stream_;          ///< Null if creation failed or finished
+    Options options_;                                         ///< What to write
+    double sampleRate_ = 44100.0;                             ///< For notes without host time
+
+    juce::int64 trackLengthPosition_ = 0;                     ///< Where the MTrk length goes
+    juce::int64 trackStartPosition_ = 0;                      ///< First byte of track data
+    juce::int64 lastTick_ = 0;                                ///< Time of the last written event
+    juce::int64 numNotes_ = 0;                                ///< Notes written
+
+    // Tempo and placement of notes without host time
+    double bpm_ = 0.0;                                        ///< Current file tempo (0 before the first note)
+    juce::int64 anchorSample_ = 0;                            ///< Onset of the last placed note
+    double anchorTick_ = 0.0;                                 ///< Its tick
+    int lastPitchBend_[16];                                   ///< Bend in effect on each channel
+    std::vector<ChordEvent> pendingChords_;                   ///< Markers waiting for the notes to catch up
+    std::vector<PendingNoteOff> pendingNoteOffs_;             ///< Note-offs in time order, waiting the same way
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiFileWriter)
+};
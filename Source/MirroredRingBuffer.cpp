@@ -0,0 +1,60 @@
+#include "MirroredRingBuffer.h"
+
+//==============================================================================
+void MirroredRingBuffer::attach(float* storage, int capacity)
+{
+    jassert(juce::isPowerOfTwo(capacity));
+
+    storage_ = storage;
+    capacity_ = capacity;
+    clear();
+}
+
+void MirroredRingBuffer::clear()
+{
+    if (storage_ != nullptr)
+        juce::zeromem(storage_, static_cast<size_t>(capacity_) * 2 * sizeof(float));
+
+    writePosition_ = 0;
+}
+
+void MirroredRingBuffer::write(const float* data, int numSamples)
+{
+    jassert(numSamples <= capacity_);
+
+    // Split at the end of the primary half, then mirror each run into the other half
+    const int size1 = juce::jmin(numSamples, capacity_ - writePosition_);
+    const int size2 = numSamples - size1;
+    float* primary = storage_;
+
+    std::copy(data, data + size1, primary + writePosition_);
+    std::copy(data, data + size1, primary + writePosition_ + capacity_);
+
+    if (size2 > 0)
+    {
+        std::copy(data + size1, data + numSamples, primary);
+        std::copy(data + size1, data + numSamples, primary + capacity_);
+    }
+
+    writePosition_ = (writePosition_ + numSamples) & (capacity_ - 1);
+}
+
+void MirroredRingBuffer::writeSilence(int numSamples)
+{
+    jassert(numSamples <= capacity_);
+
+    const int size1 = juce::jmin(numSamples, capacity_ - writePosition_);
+    const int size2 = numSamples - size1;
+    float* primary = storage_;
+
+    std::fill(primary + writePosition_, primary + writePosition_ + size1, 0.0f);
+    std::fill(primary + writePosition_ + capacity_, primary + writePosition_ + capacity_ + size1, 0.0f);
+
+    if (size2 > 0)
+    {
+        std::fill(primary, primary + size2, 0.0f);
+        std::fill(primary + capacity_, primary + capacity_ + size2, 0.0f);
+    }
+
+    writePosition_ = (writePosition_ + numSamples) & (capacity_ - 1);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+//==============================================================================
+/**
+ * Single-producer ring buffer of samples that stores every sample twice.
+ *
+ * The storage is a double-length mirror: sample n is written at n % capacity
+ * and at n % capacity + capacity. Any run of up to `capacity` consecutive
+ * samples is therefore one contiguous span, so readers never have to handle
+ * wrap-around or copy the data out first. Storage is provided by the owner.
+ */
+class MirroredRingBuffer
+{
+public:
+    //==============================================================================
+    MirroredRingBuffer() = default;
+    ~MirroredRingBuffer() = default;
+
+    /**
+     * Gets the storage size needed for a capacity.
+     *
+     * @param capacity Number of samples retained
+     * @return Number of floats attach() expects
+     */
+    static int getRequiredStorageSize(int capacity) { return capacity * 2; }
+
+    /**
+     * Uses external storage and clears the buffer.
+     *
+     * @param storage  getRequiredStorageSize(capacity) floats, owned by the caller
+     * @param capacity Number of samples retained (power of two)
+     */
+    void attach(float* storage, int capacity);
+
+    /** Zeroes the contents and rewinds the write position. */
+    void clear();
+
+    /**
+     * Appends samples, overwriting the oldest ones.
+     *
+     * @param data       Samples to append
+     * @param numSamples Number of samples (at most getCapacity())
+     */
+    void write(const float* data, int numSamples);
+
+    /**
+     * Appends zeros, overwriting the oldest samples.
+     *
+     * @param numSamples Number of samples (at most getCapacity())
+     */
+    void writeSilence(int numSamples);
+
+    /**
+     * Gets a contiguous view of retained samples.
+     *
+     * @param position Ring position of the first sample (0 to capacity-1)
+     * @return Pointer valid for getCapacity() samples
+     */
+    const float* getSpan(int position) const { return storage_ + position; }
+
+    /**
+     * Gets the ring position of a sample written `samplesAgo` samples back.
+     *
+     * @param samplesAgo Distance from the write position (1 = newest sample)
+     * @return Ring position (0 to capacity-1)
+     */
+    int getPositionSamplesAgo(int samplesAgo) const { return (writePosition_ - samplesAgo) & (capacity_ - 1); }
+
+    /** Gets the number of samples retained. */
+    int getCapacity() const { return capacity_; }
+
+private:
+    //==============================================================================
+    float* storage_ = nullptr;                                ///< 2 * capacity_ samples (second half mirrors the first)
+    int capacity_ = 0;                                        ///< Samples retained (power of two)
+    int writePosition_ = 0;                                   ///< Ring position of the next write
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MirroredRingBuffer)
+};
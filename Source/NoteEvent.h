@@ -0,0 +1,45 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+//==============================================================================
+/**
+ * One recorded note, stored run-length style: a held note is a single record
+ * from onset to offset rather than one entry per analysis frame.
+ * Trivially copyable so it can travel through a LockFreeQueue.
+ */
+struct NoteEvent
+{
+    juce::int64 onsetSample = 0;        ///< Samples since the recording started
+    juce::int64 offsetSample = -1;      ///< End of the note, or -1 while it is still sounding
+    double onsetPpq = 0.0;              ///< Host timeline onset in quarter notes
+    double offsetPpq = 0.0;             ///< Host timeline offset in quarter notes
+    double onsetSeconds = 0.0;          ///< Host timeline onset in seconds
+    float bpm = 0.0f;                   ///< Host tempo at the onset
+    juce::int32 bar = 0;                ///< Host bar index of the onset (0 = first bar)
+    juce::uint32 sessionId = 0;         ///< Recording session the event belongs to
+    juce::int8 midiNoteNumber = -1;     ///< MIDI note number (0-127)
+    juce::int8 centsOffset = 0;         ///< Average pitch deviation from the note in cents
+    juce::uint8 peakVelocity = 0;       ///< Loudest level reached (1-127)
+    juce::uint8 meanVelocity = 0;       ///< Average level over the note (1-127)
+    juce::int8 sourceChannel = -1;      ///< Channel analysed independently or string it was played on, or -1 if the only source
+    bool hasHostTime = false;           ///< Timeline fields are valid (host transport running, or a tracked beat)
+
+    /** Number of sources that can each have a note sounding at once (the strings of a divided pickup). */
+    static constexpr int maxSources = 8;
+
+    /** Gets the slot of the source the note came from (0 to maxSources - 1; the only source takes slot 0). */
+    int getSourceSlot() const { return juce::jlimit(0, maxSources - 1, (int) sourceChannel); }
+
+    /** Checks if the note had not ended when the event was produced. */
+    bool isSounding() const { return offsetSample < 0; }
+
+    /**
+     * Checks if the note was dropped where it started. Such an event only ends
+     * the sounding note announced for it and isn't a note itself.
+     */
+    bool isCancelled() const { return offsetSample == onsetSample; }
+
+    /** Gets the note length in samples (0 while sounding). */
+    juce::int64 getDuration() const { return isSounding() ? 0 : offsetSample - onsetSample; }
+};
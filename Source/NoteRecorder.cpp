@@ -0,0 +1,252 @@
+#include "NoteRecorder.h"
+#include <juce_events/juce_events.h>
+#include <algorithm>
+#include <limits>
+
+//==============================================================================
+NoteRecorder::NoteRecorder()
+    : juce::Thread("Note Recorder")
+    , chunkPool_(std::make_shared<RecordingStore::ChunkPool>())
+{
+    // The drain thread is started by the first session, not at plugin instantiation
+}
+
+NoteRecorder::~NoteRecorder()
+{
+    stopThread(1000);
+
+    // Finish a take stopped just before shutdown so its MIDI file is complete
+    serviceRequests();
+}
+
+//==============================================================================
+void NoteRecorder::startSession(double sampleRate)
+{
+    const int maxResidentChunks = (int) (memoryCapBytes_.load(std::memory_order_relaxed)
+                                         / sizeof(RecordingStore::Chunk));
+
+    // Have the first chunks ready so the drain thread doesn't allocate at the start of a take
+    chunkPool_->reserve(juce::jmin(2, maxResidentChunks));
+
+    Request request;
+    request.sessionId = sessionId_.load(std::memory_order_relaxed) + 1;
+    request.store = std::make_shared<RecordingStore>(chunkPool_, maxResidentChunks, maxChordsPerSession_);
+    request.midiWriter = std::make_unique<MidiFileWriter>(juce::File::getSpecialLocation(juce::File::tempDirectory)
+                                                              .getNonexistentChildFile("MonolithMaestroRecording", ".mid", false),
+                                                          sampleRate, midiFileOptions_);
+
+    {
+        const juce::ScopedLock lock(requestLock_);
+        requests_.push_back(std::move(request));
+    }
+
+    // Queued before the audio thread can tag events with the new id
+    sessionId_.fetch_add(1, std::memory_order_acq_rel);
+
+    if (!isThreadRunning())
+        startThread(juce::Thread::Priority::low);
+}
+
+void NoteRecorder::stopSession(juce::int64 endPosition, double endPpq,
+                               std::function<void(std::shared_ptr<RecordingStore>)> onStopped)
+{
+    Request request;
+    request.sessionId = sessionId_.load(std::memory_order_relaxed);
+    request.isStop = true;
+    request.endPosition = endPosition;
+    request.endPpq = endPpq;
+    request.onStopped = std::move(onStopped);
+
+    {
+        const juce::ScopedLock lock(requestLock_);
+        requests_.push_back(std::move(request));
+    }
+
+    if (!isThreadRunning())
+        startThread(juce::Thread::Priority::low);
+
+    notify();
+}
+
+//==============================================================================
+void NoteRecorder::run()
+{
+    while (!threadShouldExit())
+    {
+        wait(drainIntervalMs_);
+        serviceRequests();
+        drainQueue();
+    }
+}
+
+void NoteRecorder::serviceRequests()
+{
+    std::vector<Request> requests;
+    {
+        const juce::ScopedLock lock(requestLock_);
+        std::swap(requests, requests_);
+    }
+
+    for (auto& request : requests)
+    {
+        // Everything queued so far belongs to the sessions up to this request
+        drainQueue();
+
+        if (!request.isStop)
+        {
+            currentSessionId_ = request.sessionId;
+            store_ = std::move(request.store);
+            midiWriter_ = std::move(request.midiWriter);
+            openNotes_.fill({});
+            heldNotes_.clear();
+
+            // Events for a session after this one go back to being held
+            std::vector<ChordEvent> earlyChords;
+            std::vector<NoteEvent> earlyNotes;
+            std::swap(earlyChords, earlyChords_);
+            std::swap(earlyNotes, earlyNotes_);
+
+            for (const auto& chord : earlyChords)
+                storeChord(chord);
+
+            for (const auto& event : earlyNotes)
+                storeNote(event);
+
+            continue;
+        }
+
+        if (request.sessionId == currentSessionId_ && store_ != nullptr)
+        {
+            // Close the notes still sounding when recording stopped
+            for (auto& note : openNotes_)
+            {
+                if (note.midiNoteNumber < 0)
+                    continue;
+
+                note.offsetSample = juce::jmax(request.endPosition, note.onsetSample);
+                note.offsetPpq = juce::jmax(request.endPpq, note.onsetPpq);
+                holdNote(note);
+                note = {};
+            }
+
+            releaseHeldNotes(true);
+        }
+
+        auto store = request.sessionId == currentSessionId_ ? std::move(store_) : nullptr;
+        auto midiWriter = request.sessionId == currentSessionId_ ? std::move(midiWriter_) : nullptr;
+
+        if (store == nullptr)
+        {
+            store = std::make_shared<RecordingStore>(chunkPool_, 1);
+        }
+        else
+        {
+            if (midiWriter != nullptr)
+            {
+                if (midiWriter->finish())
+                    store->setMidiFile(midiWriter->getFile());
+                else
+                    midiWriter->getFile().deleteFile();
+            }
+
+            store->finish();
+        }
+
+        if (request.onStopped != nullptr)
+        {
+            juce::MessageManager::callAsync([store, onStopped = std::move(request.onStopped)]
+            {
+                onStopped(store);
+            });
+        }
+    }
+}
+
+void NoteRecorder::drainQueue()
+{
+    // Chords first: the MIDI writer holds them back until the notes catch up
+    ChordEvent chord;
+    while (chordQueue_.pop(chord))
+        storeChord(chord);
+
+    NoteEvent event;
+    while (queue_.pop(event))
+        storeNote(event);
+}
+
+void NoteRecorder::storeChord(const ChordEvent& chord)
+{
+    // A session started on the message thread but not yet set up here keeps its events;
+    // stragglers from a finished or previous session are dropped
+    if (isLaterSession(chord.sessionId))
+    {
+        earlyChords_.push_back(chord);
+        return;
+    }
+
+    if (chord.sessionId != currentSessionId_ || store_ == nullptr)
+        return;
+
+    store_->appendChord(chord);
+
+    if (midiWriter_ != nullptr)
+        midiWriter_->writeChord(chord);
+}
+
+void NoteRecorder::storeNote(const NoteEvent& event)
+{
+    if (isLaterSession(event.sessionId))
+    {
+        earlyNotes_.push_back(event);
+        return;
+    }
+
+    if (event.sessionId != currentSessionId_ || store_ == nullptr)
+        return;
+
+    auto& openNote = openNotes_[(size_t) event.getSourceSlot()];
+
+    if (event.isSounding())
+    {
+        openNote = event;
+        return;
+    }
+
+    // The finished event replaces the note it announced (a cancelled one is dropped where it started)
+    openNote = {};
+
+    if (!event.isCancelled())
+        holdNote(event);
+
+    releaseHeldNotes(false);
+}
+
+void NoteRecorder::holdNote(const NoteEvent& event)
+{
+    const auto position = std::upper_bound(heldNotes_.begin(), heldNotes_.end(), event,
+                                           [](const NoteEvent& a, const NoteEvent& b) { return a.onsetSample < b.onsetSample; });
+    heldNotes_.insert(position, event);
+}
+
+void NoteRecorder::releaseHeldNotes(bool releaseAll)
+{
+    // A note still sounding will be stored at its onset, so nothing after that may go first
+    auto firstOpenOnset = std::numeric_limits<juce::int64>::max();
+
+    if (!releaseAll)
+        for (const auto& note : openNotes_)
+            if (note.midiNoteNumber >= 0)
+                firstOpenOnset = juce::jmin(firstOpenOnset, note.onsetSample);
+
+    size_t numReleased = 0;
+
+    for (; numReleased < heldNotes_.size() && heldNotes_[numReleased].onsetSample <= firstOpenOnset; ++numReleased)
+    {
+        store_->append(heldNotes_[numReleased]);
+
+        if (midiWriter_ != nullptr)
+            midiWriter_->writeNote(heldNotes_[numReleased]);
+    }
+
+    heldNotes_.erase(heldNotes_.begin(), heldNotes_.begin() + (std::ptrdiff_t) numReleased);
+}
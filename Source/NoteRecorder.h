@@ -0,0 +1,167 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "ChordEvent.h"
+#include "LockFreeQueue.h"
+#include "MidiFileWriter.h"
+#include "NoteEvent.h"
+#include "RecordingStore.h"
+#include <array>
+#include <functional>
+#include <vector>
+
+//==============================================================================
+/**
+ * Records note events without touching locks or the heap on the audio thread.
+ *
+ * The audio thread pushes fixed-size NoteEvents into a wait-free SPSC queue;
+ * a background thread drains the queue into a bounded-memory RecordingStore.
+ * Events carry the id of the session they were produced for, so stragglers
+ * from a previous session are discarded.
+ *
+ * Several sources (input channels, strings) can each have a note sounding.
+ * A finished note is held back until no note still sounding on another
+ * source started before it, so the store and MIDI file get notes in onset
+ * order.
+ *
+ * The drain thread also streams every finished note into a Standard MIDI File,
+ * so a session can be exported however long it ran without building it in
+ * memory or on the message thread. Chord changes take a queue of their own
+ * and end up in the store and, as markers, in the MIDI file.
+ *
+ * The store and MIDI file belong to the drain thread alone. Starting and
+ * stopping a session only hands it a request, so the message thread never
+ * waits on the drain thread's disk I/O; a stopped session is finished there
+ * and delivered through a callback.
+ */
+class NoteRecorder : private juce::Thread
+{
+public:
+    //==============================================================================
+    NoteRecorder();
+    ~NoteRecorder() override;
+
+    //==============================================================================
+    /**
+     * Starts a new recording session (message thread).
+     *
+     * @param sampleRate Sample rate the event positions are counted at
+     */
+    void startSession(double sampleRate);
+
+    /**
+     * Ends the current session (message thread). Returns at once; the drain
+     * thread takes the events still queued, closes the notes left sounding and
+     * finishes the store and MIDI file.
+     *
+     * @param endPosition Session length in samples, where sounding notes are closed
+     * @param endPpq Host timeline position of the session end
+     * @param onStopped Called on the message thread with the finished recording (never null)
+     */
+    void stopSession(juce::int64 endPosition, double endPpq,
+                     std::function<void(std::shared_ptr<RecordingStore>)> onStopped);
+
+    /**
+     * Sets how much event memory a session may keep resident before older
+     * chunks are spilled to disk. Takes effect at the next session.
+     */
+    void setMemoryCap(size_t bytes) { memoryCapBytes_.store(bytes, std::memory_order_relaxed); }
+
+    /** Sets how the MIDI file is written (message thread). Takes effect at the next session. */
+    void setMidiFileOptions(const MidiFileWriter::Options& options) { midiFileOptions_ = options; }
+
+    //==============================================================================
+    /**
+     * Gets the id of the current session (audio thread).
+     * A change means a new session started and per-session state should reset.
+     */
+    juce::uint32 getSessionId() const { return sessionId_.load(std::memory_order_acquire); }
+
+    /**
+     * Queues an event for the session named in event.sessionId (audio thread).
+     * Sounding events announce a note; the finished event for it replaces them.
+     * Each source (event.sourceChannel) has at most one note sounding.
+     * Wait-free; the event is dropped if the queue is full.
+     *
+     * @return false if the event was dropped
+     */
+    bool pushEvent(const NoteEvent& event) { return queue_.push(event); }
+
+    /**
+     * Queues a chord change for the session named in event.sessionId (audio thread).
+     * Wait-free; the event is dropped if the queue is full.
+     *
+     * @return false if the event was dropped
+     */
+    bool pushChord(const ChordEvent& event) { return chordQueue_.push(event); }
+
+private:
+    //==============================================================================
+    /** A session start or stop, handed from the message thread to the drain thread. */
+    struct Request
+    {
+        juce::uint32 sessionId = 0;                           ///< Session started or stopped
+        bool isStop = false;                                  ///< Stop (otherwise start)
+        std::shared_ptr<RecordingStore> store;                ///< Start: the new session's store
+        std::unique_ptr<MidiFileWriter> midiWriter;           ///< Start: the new session's SMF
+        juce::int64 endPosition = 0;                          ///< Stop: where sounding notes are closed
+        double endPpq = 0.0;                                  ///< Stop: host timeline position of the end
+        std::function<void(std::shared_ptr<RecordingStore>)> onStopped; ///< Stop: receives the store
+    };
+
+    void run() override;
+
+    /** Carries out the pending starts and stops in order (drain thread). */
+    void serviceRequests();
+
+    /** Moves all queued events into the session store (drain thread). */
+    void drainQueue();
+
+    /** Routes a popped note event to the current session, holds it for the next one, or drops it (drain thread). */
+    void storeNote(const NoteEvent& event);
+
+    /** Routes a popped chord change the same way (drain thread). */
+    void storeChord(const ChordEvent& event);
+
+    /** Adds a finished note to the held notes, in onset order (drain thread). */
+    void holdNote(const NoteEvent& event);
+
+    /**
+     * Writes the held notes no sounding note can precede any more (drain thread).
+     *
+     * @param releaseAll Write every held note (the session is ending)
+     */
+    void releaseHeldNotes(bool releaseAll);
+
+    /** Checks if a session id comes after the current session's (the next session, already started). */
+    bool isLaterSession(juce::uint32 id) const { return (juce::int32) (id - currentSessionId_) > 0; }
+
+    static constexpr int queueCapacity_ = 4096;               ///< Events buffered between drains
+    static constexpr int chordQueueCapacity_ = 256;           ///< Chord changes buffered between drains
+    static constexpr int maxChordsPerSession_ = 16384;        ///< Chord changes a take keeps (hours at one per second)
+    static constexpr int drainIntervalMs_ = 20;               ///< Background drain period
+
+    LockFreeQueue<NoteEvent> queue_ { queueCapacity_ };       ///< Audio thread -> drain thread
+    LockFreeQueue<ChordEvent> chordQueue_ { chordQueueCapacity_ }; ///< Audio thread -> drain thread
+    std::atomic<juce::uint32> sessionId_{ 0 };                ///< Latest session started
+
+    static constexpr size_t defaultMemoryCapBytes_ = 1 << 20; ///< Resident events before spilling
+
+    std::shared_ptr<RecordingStore::ChunkPool> chunkPool_;    ///< Chunks recycled across sessions
+    std::atomic<size_t> memoryCapBytes_{ defaultMemoryCapBytes_ }; ///< Resident limit per session
+    MidiFileWriter::Options midiFileOptions_;                 ///< For the next session's SMF
+
+    juce::CriticalSection requestLock_;                       ///< Guards requests_ (never held during I/O)
+    std::vector<Request> requests_;                           ///< Starts and stops not yet carried out
+
+    // Drain thread only
+    juce::uint32 currentSessionId_ = 0;                       ///< Session the store below belongs to
+    std::shared_ptr<RecordingStore> store_;                   ///< Current session's store (null once stopped)
+    std::unique_ptr<MidiFileWriter> midiWriter_;              ///< Current session's SMF
+    std::vector<NoteEvent> earlyNotes_;                       ///< Next session's events popped before it was set up
+    std::vector<ChordEvent> earlyChords_;                     ///< Same, for chord changes
+    std::array<NoteEvent, NoteEvent::maxSources> openNotes_;  ///< Note sounding on each source (midiNoteNumber < 0 if none)
+    std::vector<NoteEvent> heldNotes_;                        ///< Finished notes waiting for earlier ones, in onset order
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NoteRecorder)
+};
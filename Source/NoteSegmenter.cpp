@@ -0,0 +1,176 @@
+#include "NoteSegmenter.h"
+#include <cmath>
+
+//==============================================================================
+void NoteSegmenter::prepare(double sampleRate, int onsetLookbackSamples)
+{
+    levelHopSamples_ = juce::jmax(1, juce::roundToInt(sampleRate * 0.01));
+    onsetLookbackSamples_ = onsetLookbackSamples;
+    reset(0);
+}
+
+void NoteSegmenter::reset(juce::int64 streamPosition)
+{
+    hopEnergy_ = 0.0;
+    hopSamples_ = 0;
+    blockEndSample_ = streamPosition;
+    currentLevel_ = 0.0f;
+    previousLevel_ = 0.0f;
+    attackSample_ = -1;
+
+    activeNote_ = -1;
+    onsetSample_ = 0;
+    peakLevel_ = 0.0f;
+    levelSum_ = 0.0;
+    levelSamples_ = 0;
+    centsSum_ = 0.0;
+    numCentsFrames_ = 0;
+
+    releasedNote_ = -1;
+    releaseSample_ = -1;
+}
+
+//==============================================================================
+int NoteSegmenter::processBlock(const PitchDetector::FrameResult& frame, float level,
+                                juce::int64 blockEndSample, NoteEvent* events)
+{
+    int numEvents = 0;
+
+    // Accumulate the block into the current level hop
+    const auto numSamples = blockEndSample - blockEndSample_;
+    blockEndSample_ = blockEndSample;
+
+    if (numSamples > 0)
+    {
+        hopEnergy_ += (double) level * level * (double) numSamples;
+        hopSamples_ += numSamples;
+    }
+
+    if (hopSamples_ >= levelHopSamples_)
+    {
+        const auto hopLevel = (float) std::sqrt(hopEnergy_ / (double) hopSamples_);
+        processLevel(hopLevel, blockEndSample - hopSamples_, hopSamples_, events, numEvents);
+        hopEnergy_ = 0.0;
+        hopSamples_ = 0;
+    }
+
+    if (frame.frameIndex != lastFrameIndex_)
+    {
+        lastFrameIndex_ = frame.frameIndex;
+        processFrame(frame, events, numEvents);
+    }
+
+    jassert(numEvents <= maxEventsPerBlock);
+    return numEvents;
+}
+
+void NoteSegmenter::processLevel(float level, juce::int64 hopStartSample, juce::int64 hopSamples,
+                                 NoteEvent* events, int& numEvents)
+{
+    previousLevel_ = currentLevel_;
+    currentLevel_ = level;
+
+    if (level >= levelFloor_ && level >= previousLevel_ * attackRatio_)
+        attackSample_ = hopStartSample;
+
+    if (activeNote_ < 0)
+        return;
+
+    // Energy decay ends the note even if the pitch is still (faintly) detected
+    if (level < levelFloor_ || level < peakLevel_ * releaseRatio_)
+    {
+        closeNote(hopStartSample, events, numEvents);
+        return;
+    }
+
+    peakLevel_ = juce::jmax(peakLevel_, level);
+    levelSum_ += (double) level * (double) hopSamples;
+    levelSamples_ += hopSamples;
+}
+
+void NoteSegmenter::processFrame(const PitchDetector::FrameResult& frame, NoteEvent* events, int& numEvents)
+{
+    const int note = frame.midiNoteNumber;
+
+    // The latest attack marks the onset if it belongs to the note this frame reports
+    const bool hasRecentAttack = attackSample_ >= frame.frameEndSample - onsetLookbackSamples_
+                                 && attackSample_ > releaseSample_
+                                 && (activeNote_ < 0 || attackSample_ > onsetSample_);
+    const auto onsetSample = hasRecentAttack ? attackSample_ : frame.frameEndSample;
+
+    if (note == activeNote_)
+    {
+        // Re-attack of the sounding note: split it so repeated notes are kept
+        if (note >= 0 && hasRecentAttack)
+        {
+            closeNote(attackSample_, events, numEvents);
+            openNote(note, frame.centsOffset, attackSample_, events, numEvents);
+        }
+        else if (note >= 0)
+        {
+            centsSum_ += frame.centsOffset;
+            ++numCentsFrames_;
+        }
+
+        return;
+    }
+
+    if (activeNote_ >= 0)
+        closeNote(note >= 0 ? onsetSample : frame.frameEndSample, events, numEvents);
+
+    // Frames still reporting a note that decayed are its tail, not a new note
+    if (note < 0 || (note == releasedNote_ && !hasRecentAttack))
+        return;
+
+    openNote(note, frame.centsOffset, onsetSample, events, numEvents);
+}
+
+//==============================================================================
+void NoteSegmenter::openNote(int midiNoteNumber, float centsOffset, juce::int64 onsetSample,
+                             NoteEvent* events, int& numEvents)
+{
+    activeNote_ = midiNoteNumber;
+    onsetSample_ = onsetSample;
+    peakLevel_ = currentLevel_;
+    levelSum_ = 0.0;
+    levelSamples_ = 0;
+    centsSum_ = centsOffset;
+    numCentsFrames_ = 1;
+    releasedNote_ = -1;
+
+    events[numEvents++] = makeEvent();
+}
+
+void NoteSegmenter::closeNote(juce::int64 offsetSample, NoteEvent* events, int& numEvents)
+{
+    auto event = makeEvent();
+
+    // A note cut off where it started (e.g. its attack turned out to be the next note's) is dropped,
+    // but its zero-length event still withdraws the sounding event that announced it
+    event.offsetSample = juce::jmax(offsetSample, event.onsetSample);
+
+    releasedNote_ = activeNote_;
+    releaseSample_ = offsetSample;
+    activeNote_ = -1;
+
+    events[numEvents++] = event;
+}
+
+NoteEvent NoteSegmenter::makeEvent() const
+{
+    NoteEvent event;
+    event.onsetSample = onsetSample_;
+    event.midiNoteNumber = (juce::int8) activeNote_;
+    event.centsOffset = (juce::int8) juce::jlimit(-100, 100, juce::roundToInt(centsSum_ / juce::jmax(1, numCentsFrames_)));
+    event.peakVelocity = levelToVelocity(peakLevel_);
+    event.meanVelocity = levelToVelocity(levelSamples_ > 0 ? (float) (levelSum_ / (double) levelSamples_)
+                                                           : peakLevel_);
+    return event;
+}
+
+juce::uint8 NoteSegmenter::levelToVelocity(float level)
+{
+    // 0 dB = full-scale sine (RMS 1/sqrt(2)); velocity falls linearly to 1 at -60 dB
+    const float decibels = 20.0f * std::log10(juce::jmax(level * 1.41421356f, 1.0e-6f));
+    return (juce::uint8) juce::jlimit(1, 127, juce::roundToInt(127.0f * (1.0f + decibels / 60.0f)));
+}
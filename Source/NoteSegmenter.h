@@ -0,0 +1,116 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "NoteEvent.h"
+#include "PitchDetector.h"
+
+//==============================================================================
+/**
+ * Turns the detector's per-frame results into note events with onsets,
+ * offsets and velocities.
+ *
+ * Runs on the audio thread after PitchDetector::processAudioBlock(). Pitch
+ * comes from the (stability-filtered) frame results; timing comes from the
+ * per-block input level, which has much finer resolution than the analysis
+ * frames:
+ *  - an onset is placed at the most recent attack (level jump or rise above the
+ *    floor) if it falls inside the frames that confirmed the note,
+ *  - an offset is placed where the level decays below a fraction of the note's
+ *    peak, or where the detected pitch changes or disappears,
+ *  - a fresh attack on the note that is already sounding splits it, so repeated
+ *    notes are kept.
+ * Levels are evaluated over hops of about 10 ms whatever the host block size,
+ * so tiny blocks don't turn the waveform's own ripple into attacks.
+ */
+class NoteSegmenter
+{
+public:
+    //==============================================================================
+    /** Maximum number of events a single processBlock() call can produce. */
+    static constexpr int maxEventsPerBlock = 2;
+
+    NoteSegmenter() = default;
+
+    /**
+     * Prepares the segmenter.
+     *
+     * @param sampleRate Audio sample rate in Hz
+     * @param onsetLookbackSamples How far before a frame's end an attack may lie and
+     *                             still count as the onset of the note that frame reports
+     */
+    void prepare(double sampleRate, int onsetLookbackSamples);
+
+    /** Forgets any sounding note. */
+    void reset(juce::int64 streamPosition);
+
+    /**
+     * Advances by one audio block.
+     *
+     * @param frame Latest detector result
+     * @param level RMS level of the block
+     * @param blockEndSample Stream position just past the block
+     * @param events Receives up to maxEventsPerBlock events: finished notes
+     *               (offsetSample set, isCancelled() if dropped) and newly
+     *               started ones (isSounding())
+     * @return Number of events written
+     */
+    int processBlock(const PitchDetector::FrameResult& frame, float level,
+                     juce::int64 blockEndSample, NoteEvent* events);
+
+    //==============================================================================
+    /** Sets the level below which no note is considered sounding. */
+    void setLevelFloor(float level) { levelFloor_ = level; }
+
+    /** Converts an RMS level to a MIDI velocity (1-127, 60 dB range). */
+    static juce::uint8 levelToVelocity(float level);
+
+private:
+    //==============================================================================
+    /** Evaluates one level hop: attack detection and energy-decay offsets. */
+    void processLevel(float level, juce::int64 hopStartSample, juce::int64 hopSamples,
+                      NoteEvent* events, int& numEvents);
+
+    /** Applies a new frame result: pitch changes, new notes and re-attacks. */
+    void processFrame(const PitchDetector::FrameResult& frame, NoteEvent* events, int& numEvents);
+
+    /** Starts a note and writes its (still sounding) event. */
+    void openNote(int midiNoteNumber, float centsOffset, juce::int64 onsetSample,
+                  NoteEvent* events, int& numEvents);
+
+    /** Ends the sounding note and writes its event (dropped if it has no length). */
+    void closeNote(juce::int64 offsetSample, NoteEvent* events, int& numEvents);
+
+    /** Fills the fields shared by open and closed events for the active note. */
+    NoteEvent makeEvent() const;
+
+    // Configuration
+    float levelFloor_ = 0.001f;                               ///< Silence threshold (RMS)
+    static constexpr float releaseRatio_ = 0.1f;              ///< Decay below peak that ends a note (-20 dB)
+    static constexpr float attackRatio_ = 2.0f;               ///< Block-to-block rise that marks an attack (+6 dB)
+    int onsetLookbackSamples_ = 0;                            ///< Oldest usable attack relative to a frame
+
+    // Level tracking
+    int levelHopSamples_ = 441;                               ///< Samples per level evaluation
+    double hopEnergy_ = 0.0;                                  ///< Sum of squares in the current hop
+    juce::int64 hopSamples_ = 0;                              ///< Samples in the current hop
+    juce::int64 blockEndSample_ = 0;                          ///< End of the previous block
+    float currentLevel_ = 0.0f;                               ///< Level of the last complete hop
+    float previousLevel_ = 0.0f;                              ///< Level of the hop before that
+    juce::int64 attackSample_ = -1;                           ///< Start of the most recent attack
+    juce::uint32 lastFrameIndex_ = 0;                         ///< Last FrameResult consumed
+
+    // Sounding note
+    int activeNote_ = -1;                                     ///< MIDI note, or -1 when silent
+    juce::int64 onsetSample_ = 0;                             ///< Onset of the active note
+    float peakLevel_ = 0.0f;                                  ///< Loudest block of the active note
+    double levelSum_ = 0.0;                                   ///< Sample-weighted level sum
+    juce::int64 levelSamples_ = 0;                            ///< Samples in levelSum_
+    double centsSum_ = 0.0;                                   ///< Sum of the note's frame pitch deviations
+    int numCentsFrames_ = 0;                                  ///< Frames in centsSum_
+
+    // Last finished note
+    int releasedNote_ = -1;                                   ///< Note that last ended
+    juce::int64 releaseSample_ = -1;                          ///< Where it ended
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NoteSegmenter)
+};
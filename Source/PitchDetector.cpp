@@ -2,249 +2,1050 @@
 
 //==============================================================================
 PitchDetector::PitchDetector()
-    : fft_(std::make_unique<juce::dsp::FFT>(fftOrder_))
-    , fifo_(fftSize_ + 1)  // +1 because JUCE AbstractFifo holds size-1 items
 {
-    // Allocate FFT buffers (pre-allocation for real-time safety)
-    fftBuffer_.allocate(fftSize_ * 2, true);      // *2 for complex numbers
-    fftMagnitudes_.allocate(fftSize_, true);
-    windowBuffer_.allocate(fftSize_, true);
-
-    // Pre-compute Hann window: w(n) = 0.5 * (1 - cos(2π * n / (N-1)))
-    for (int i = 0; i < fftSize_; ++i)
-    {
-        windowBuffer_[i] = 0.5f * (1.0f - std::cos(2.0f * juce::MathConstants<float>::pi * i / (fftSize_ - 1.0f)));
-    }
-
-    fifoBuffer_.resize(fftSize_, 0.0f);
-    detectedNotes_.reserve(maxNotes_);
-
-    // Initialize frequency-to-note mapping
-    initializeFrequencyMap();
+    // Nothing to build here: tables are compile-time or shared, and the FFT
+    // engine and all sample-rate dependent memory are allocated in prepare()
 }
 
 //==============================================================================
 void PitchDetector::prepare(double sampleRate, int expectedBlockSize)
 {
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
     sampleRate_ = sampleRate;
     expectedBlockSize_ = expectedBlockSize;
+
+    tables_ = SharedAnalysisTables::acquire(fftOrder_, windowType_, sampleRate_);
+
+    // Detectors on other threads (other tracks, or a DetectorPool) may transform at the same time
+    if (subFft_ == nullptr)
+        subFft_ = std::make_unique<juce::dsp::FFT>(fftOrder_ - 2);
+
+    windowBuffer_ = tables_->getWindow();
+    twiddles_ = tables_->getTwiddles();
+    chromaWeights_ = tables_->getChromaWeights();
+    numChromaWeights_ = tables_->getNumChromaWeights();
+    setChromaHalfLife(chromaHalfLifeSeconds_);
+    preFilter_.prepare(sampleRate_, preFilterSettings_);
+
+    // The peak search never reaches below bin 2 (DC and very low frequency noise)
+    const double hzPerBin = sampleRate_ / fftSize_;
+    lowestBin_ = juce::jlimit(2, fftSize_ / 2 - 1, static_cast<int>(searchLowestHz_ / hzPerBin));
+    highestBin_ = searchHighestHz_ > 0.0f
+        ? juce::jlimit(lowestBin_, fftSize_ / 2 - 1, static_cast<int>(std::ceil(searchHighestHz_ / hzPerBin)))
+        : fftSize_ / 2 - 1;
+
+    // Separate up to C8 so the chroma benefits too (the note map itself stops at C7)
+    separationBins_ = separateHarmonics_
+        ? juce::jmin(fftSize_ / 2, static_cast<int>(CompileTimeTables::midiNoteToFrequency(108) / hzPerBin) + 1)
+        : 0;
+
+    // The reference doubles the windowing and butterflies but shares the FFTs
+    streamCost_ = useReference_ ? 2.0f : 1.0f;
+    totalSliceCost_ = baseSliceCost_ + (separationBins_ > 0 ? static_cast<float>(separateSlices_) : 0.0f)
+                                     + (useNoiseProfile_ ? static_cast<float>(denoiseSlices_) : 0.0f)
+                                     + (useReference_ ? static_cast<float>(suppressSlices_) : 0.0f)
+                                     + (streamCost_ - 1.0f) * (windowSlices_ + combineSlices_ + spectrumSlices_ * spectrumSliceCost_);
+
+    // The floor is learned over the same stretch of background whatever the frame rate
+    noiseSubwindowFrames_ = juce::jmax(1, juce::roundToInt(noiseSubwindowSeconds_ * sampleRate_ / fftSize_));
+    noiseWindowFrames_ = noiseSubwindows_ * noiseSubwindowFrames_;
+
+    // Lay out every working buffer in one arena, hottest first
+    arena_.release();
+    detachWorkingMemory();
+
+    const auto preFilterOffset = arena_.reserve<float>(preFilterChunk_);
+    const auto ringSize = static_cast<size_t>(MirroredRingBuffer::getRequiredStorageSize(fftSize_ * 2));
+    const auto ringOffset = arena_.reserve<float>(ringSize);
+    const auto referenceRingOffset = arena_.reserve<float>(useReference_ ? ringSize : 0);
+    const auto fftOffset = arena_.reserve<float>(fftSize_ * 2);
+    const auto referenceOffset = arena_.reserve<float>(useReference_ ? fftSize_ * 2 : 0);
+    const auto magnitudeOffset = arena_.reserve<float>(fftSize_ / 2);
+    const auto referenceMagnitudeOffset = arena_.reserve<float>(useReference_ ? fftSize_ / 2 : 0);
+    const auto noiseOffset = arena_.reserve<NoiseBin>(useNoiseProfile_ ? fftSize_ / 2 : 0);
+    const auto timeMedianOffset = arena_.reserve<TimeMedian>(static_cast<size_t>(separationBins_));
+    const auto candidateOffset = arena_.reserve<NoteCandidate>(maxNotes_);
+    const auto detectedOffset = arena_.reserve<NoteCandidate>(maxNotes_);
+    const auto historyOffset = arena_.reserve<NoteHistory>(maxNotes_ * 2);
+
+    if (!arena_.allocate(lockMemory_))
+        return;
+
+    preFilterBuffer_ = arena_.get<float>(preFilterOffset);
+    fftBuffer_ = arena_.get<float>(fftOffset);
+    fftMagnitudes_ = arena_.get<float>(magnitudeOffset);
+    referenceBuffer_ = useReference_ ? arena_.get<float>(referenceOffset) : nullptr;
+    referenceMagnitudes_ = useReference_ ? arena_.get<float>(referenceMagnitudeOffset) : nullptr;
+    noiseBins_ = useNoiseProfile_ ? arena_.get<NoiseBin>(noiseOffset) : nullptr;
+    timeMedians_ = separationBins_ > 0 ? arena_.get<TimeMedian>(timeMedianOffset) : nullptr;
+    candidateNotes_ = arena_.get<NoteCandidate>(candidateOffset);
+    detectedNotes_ = arena_.get<NoteCandidate>(detectedOffset);
+    noteHistory_ = arena_.get<NoteHistory>(historyOffset);
+
+    // Room for the next frame while the current one is analysed
+    inputRing_.attach(arena_.get<float>(ringOffset), fftSize_ * 2);
+
+    if (useReference_)
+        referenceRing_.attach(arena_.get<float>(referenceRingOffset), fftSize_ * 2);
+
     reset();
+
+    prepareTicks_.store(juce::Time::getHighResolutionTicks() - startTicks, std::memory_order_relaxed);
 }
 
-void PitchDetector::processAudioBlock(const float* audioData, int numSamples)
+void PitchDetector::processAudioBlock(const float* audioData, int numSamples, const float* referenceData)
 {
-    if (audioData == nullptr || numSamples <= 0)
+    if (audioData == nullptr || numSamples <= 0 || !arena_.isAllocated())
         return;
 
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
     // Check noise gate
     float rms = calculateRMS(audioData, numSamples);
+    inputLevel_ = rms;
     if (rms < noiseGateThreshold_)
     {
-        isActive_.store(false, std::memory_order_relaxed);
-        detectedNotes_.clear();
+        // Whatever sounded before the silence shouldn't count as sustained after it
+        if (isActive_.exchange(false, std::memory_order_relaxed))
+        {
+            clearTimeMedians();
+            preFilter_.reset();
+        }
+
+        numDetectedNotes_ = 0;
+
+        // Drop the in-flight frame - its result would be stale by the time it finished
+        analysisStage_ = AnalysisStage::idle;
+        sliceCredit_ = 0.0f;
+        frameChroma_.fill(0.0f);
+        chroma_.fill(0.0f);
+
+        // Publish the silence once so note tracking downstream sees the release
+        if (latestFrame_.midiNoteNumber >= 0)
+            publishFrame(streamPosition_);
+    }
+    else
+    {
+        isActive_.store(true, std::memory_order_relaxed);
+
+        // Write audio to the input ring, starting a frame as soon as enough samples accumulated
+        for (int written = 0; written < numSamples;)
+        {
+            // Samples the ring must not overwrite yet: unframed input plus a frame still being windowed
+            const bool frameUnread = analysisStage_ == AnalysisStage::window || analysisStage_ == AnalysisStage::batch;
+            const int unconsumed = pendingSamples_ + (frameUnread ? fftSize_ : 0);
+            int space = inputRing_.getCapacity() - unconsumed;
+
+            // Block larger than the ring headroom - finish the in-flight frame to free space
+            if (space == 0)
+            {
+                completeFrame();
+                space = inputRing_.getCapacity() - pendingSamples_;
+            }
+
+            const int toWrite = juce::jmin(numSamples - written, space);
+            writeInput(audioData + written, referenceData != nullptr ? referenceData + written : nullptr, toWrite);
+            pendingSamples_ += toWrite;
+            written += toWrite;
+            ringStreamPosition_ = streamPosition_ + written;
+
+            if (analysisStage_ == AnalysisStage::idle && pendingSamples_ >= fftSize_)
+                beginFrame();
+        }
+
+        // A batched frame is completed by the caller
+        if (analysisStage_ != AnalysisStage::batch)
+            advanceAnalysis(numSamples);
+    }
+
+    streamPosition_ += numSamples;
+
+    // Track the worst-case callback time
+    const auto elapsedTicks = juce::Time::getHighResolutionTicks() - startTicks;
+    auto worstTicks = worstCallbackTicks_.load(std::memory_order_relaxed);
+    while (elapsedTicks > worstTicks
+           && !worstCallbackTicks_.compare_exchange_weak(worstTicks, elapsedTicks, std::memory_order_relaxed))
+    {
+    }
+}
+
+//==============================================================================
+void PitchDetector::writeInput(const float* data, const float* referenceData, int numSamples)
+{
+    // The reference is recorded as is: it doesn't carry the input's rumble or hum
+    if (referenceBuffer_ != nullptr)
+    {
+        if (referenceData != nullptr)
+            referenceRing_.write(referenceData, numSamples);
+        else
+            referenceRing_.writeSilence(numSamples);
+    }
+
+    if (!preFilter_.isActive())
+    {
+        inputRing_.write(data, numSamples);
         return;
     }
 
-    isActive_.store(true, std::memory_order_relaxed);
+    for (int done = 0; done < numSamples;)
+    {
+        const int chunk = juce::jmin(numSamples - done, preFilterChunk_);
+        preFilter_.process(data + done, preFilterBuffer_, chunk);
+        inputRing_.write(preFilterBuffer_, chunk);
+        done += chunk;
+    }
+}
+
+void PitchDetector::beginFrame()
+{
+    // The frame is read in place; the ring keeps it intact until the window stage is done
+    frameData_ = inputRing_.getSpan(inputRing_.getPositionSamplesAgo(pendingSamples_));
+
+    if (referenceBuffer_ != nullptr)
+        referenceFrameData_ = referenceRing_.getSpan(referenceRing_.getPositionSamplesAgo(pendingSamples_));
+    pendingSamples_ -= fftSize_;
+    frameEndSample_ = ringStreamPosition_ - pendingSamples_;
 
-    // Write audio to FIFO
-    int start1, size1, start2, size2;
-    fifo_.prepareToWrite(numSamples, start1, size1, start2, size2);
+    strongestBin_ = lowestBin_;
+    strongestMagnitude_ = -1.0f;
+    stageSlice_ = 0;
+    analysisStage_ = batchTransform_ && referenceBuffer_ == nullptr ? AnalysisStage::batch : AnalysisStage::window;
+}
 
-    if (size1 > 0)
-        std::copy(audioData, audioData + size1, fifoBuffer_.data() + start1);
-    if (size2 > 0)
-        std::copy(audioData + size1, audioData + size1 + size2, fifoBuffer_.data() + start2);
+PitchDetector::AnalysisStage PitchDetector::getStageAfterSpectrum() const
+{
+    return referenceBuffer_ != nullptr ? AnalysisStage::suppress
+         : noiseBins_ != nullptr       ? AnalysisStage::denoise
+         : separationBins_ > 0         ? AnalysisStage::separate
+                                       : AnalysisStage::chroma;
+}
+
+void PitchDetector::completeBatchFrame(const float* magnitudes, int stride, int strongestBin, float strongestMagnitude)
+{
+    jassert(analysisStage_ == AnalysisStage::batch);
+    if (analysisStage_ != AnalysisStage::batch)
+        return;
 
-    fifo_.finishedWrite(size1 + size2);
+    for (int k = 0; k < fftSize_ / 2; ++k)
+        fftMagnitudes_[k] = magnitudes[k * stride];
 
-    // Perform FFT when enough samples accumulated
-    if (fifo_.getNumReady() >= fftSize_)
+    strongestBin_ = strongestBin;
+    strongestMagnitude_ = strongestMagnitude;
+    stageSlice_ = 0;
+    analysisStage_ = getStageAfterSpectrum();
+
+    // Only the transform is batched: the later stages are spread over the following callbacks as usual
+    if (!amortiseAnalysis_)
+        completeFrame();
+}
+
+void PitchDetector::advanceAnalysis(int numSamples)
+{
+    if (!amortiseAnalysis_)
     {
-        performFFTAnalysis();
+        completeFrame();
+        return;
     }
+
+    // Earn enough budget per sample to finish a frame within analysisSpreadSamples_
+    sliceCredit_ += totalSliceCost_ * numSamples / analysisSpreadSamples_;
+
+    // A batched frame waits for the caller's spectrum rather than being transformed here
+    while (sliceCredit_ > 0.0f && analysisStage_ != AnalysisStage::idle && analysisStage_ != AnalysisStage::batch)
+    {
+        sliceCredit_ -= runAnalysisSlice();
+
+        // A frame may already be waiting if blocks are large
+        if (analysisStage_ == AnalysisStage::idle && pendingSamples_ >= fftSize_)
+            beginFrame();
+    }
+
+    // Don't bank budget while idle (or waiting on the caller), but keep any overspend as debt
+    if (analysisStage_ == AnalysisStage::idle || analysisStage_ == AnalysisStage::batch)
+        sliceCredit_ = juce::jmin(sliceCredit_, 0.0f);
 }
 
-void PitchDetector::performFFTAnalysis()
+void PitchDetector::completeFrame()
+{
+    if (analysisStage_ == AnalysisStage::idle && pendingSamples_ >= fftSize_)
+        beginFrame();
+
+    while (analysisStage_ != AnalysisStage::idle)
+        runAnalysisSlice();
+}
+
+float PitchDetector::runAnalysisSlice()
 {
     //==============================================================================
-    // Simple Monophonic Pitch Detection:
-    // 1. Find the strongest frequency peak in the FFT spectrum
-    // 2. Use parabolic interpolation for sub-bin accuracy
-    // 3. Map the frequency to a note using predefined frequency ranges
-    // 4. No harmonic filtering - the loudest frequency is the detected note
+    // The 4096-point transform is computed by decimation in time so it can be split:
+    // sample 4m + r feeds quarter-size real FFT r, then two radix-2 butterfly passes
+    // recombine the quarter spectra. Each region of fftBuffer_ holds one sub-transform
+    // (subFftSize_ complex bins) and is overwritten in place by the butterflies.
+    // With a reference, referenceBuffer_ first holds the complex transform inputs
+    // (input + i * reference) and then the reference's own sub-spectra.
     //==============================================================================
+    auto* regions = reinterpret_cast<std::complex<float>*>(fftBuffer_);
+    auto* referenceRegions = reinterpret_cast<std::complex<float>*>(referenceBuffer_);
 
-    // Read samples from FIFO
-    int start1, size1, start2, size2;
-    fifo_.prepareToRead(fftSize_, start1, size1, start2, size2);
+    switch (analysisStage_)
+    {
+        case AnalysisStage::batch:
+            // The caller didn't supply the spectrum in time - transform the frame here after all
+            analysisStage_ = AnalysisStage::window;
+            return 0.0f;
 
-    juce::zeromem(fftBuffer_.getData(), fftSize_ * 2 * sizeof(float));
+        case AnalysisStage::window:
+        {
+            // Apply Hann window while reading straight from the contiguous input span.
+            // Every sub-transform input is fully overwritten, so no clearing is needed.
+            constexpr int sliceLength = fftSize_ / windowSlices_;
+            const int begin = stageSlice_ * sliceLength;
 
-    if (size1 > 0)
-        std::copy(fifoBuffer_.data() + start1, fifoBuffer_.data() + start1 + size1, fftBuffer_.getData());
-    if (size2 > 0)
-        std::copy(fifoBuffer_.data() + start2, fifoBuffer_.data() + start2 + size2, fftBuffer_.getData() + size1);
+            if (referenceBuffer_ != nullptr)
+            {
+                for (int i = begin; i < begin + sliceLength; ++i)
+                {
+                    auto* packed = referenceBuffer_ + (i & 3) * (fftSize_ / 2) + 2 * (i >> 2);
+                    packed[0] = frameData_[i] * windowBuffer_[i];
+                    packed[1] = referenceFrameData_[i] * windowBuffer_[i];
+                }
+            }
+            else
+            {
+                for (int i = begin; i < begin + sliceLength; ++i)
+                    fftBuffer_[(i & 3) * (fftSize_ / 2) + (i >> 2)] = frameData_[i] * windowBuffer_[i];
+            }
+
+            if (++stageSlice_ == windowSlices_)
+            {
+                stageSlice_ = 0;
+                analysisStage_ = AnalysisStage::transform;
+            }
+            return streamCost_;
+        }
+
+        case AnalysisStage::transform:
+        {
+            if (referenceBuffer_ != nullptr)
+            {
+                // Two real transforms for the price of one complex one, then pulled apart
+                auto* spectrum = regions + stageSlice_ * subFftSize_;
+                auto* packed = referenceRegions + stageSlice_ * subFftSize_;
+                subFft_->perform(packed, spectrum, false);
+                splitPackedSpectrum(spectrum, packed);
+            }
+            else
+            {
+                // Real-only transforms read just the first subFftSize_ floats of the region
+                subFft_->performRealOnlyForwardTransform(fftBuffer_ + stageSlice_ * (fftSize_ / 2));
+            }
+
+            if (++stageSlice_ == transformSlices_)
+            {
+                stageSlice_ = 0;
+                analysisStage_ = AnalysisStage::combine;
+            }
+            return transformSliceCost_;
+        }
+
+        case AnalysisStage::combine:
+        {
+            // Regions 0/2 combine into the even-sample spectrum, 1/3 into the odd one.
+            // E[k] is stored in the lower region and E[k + subFftSize_] in the upper.
+            constexpr int sliceLength = 2 * subFftSize_ / combineSlices_;
+            const int pair = stageSlice_ * sliceLength / subFftSize_;
+            const int begin = stageSlice_ * sliceLength % subFftSize_;
+
+            const auto combinePair = [&](std::complex<float>* stream)
+            {
+                auto* lower = stream + pair * subFftSize_;
+                auto* upper = stream + (pair + 2) * subFftSize_;
 
-    fifo_.finishedRead(size1 + size2);
+                for (int k = begin; k < begin + sliceLength; ++k)
+                {
+                    const auto a = lower[k];
+                    const auto b = twiddles_[2 * k] * upper[k];  // exp(-2πik / (fftSize_ / 2))
+                    lower[k] = a + b;
+                    upper[k] = a - b;
+                }
+            };
 
-    // Apply Hann window
-    for (int i = 0; i < fftSize_; ++i)
+            combinePair(regions);
+
+            if (referenceRegions != nullptr)
+                combinePair(referenceRegions);
+
+            if (++stageSlice_ == combineSlices_)
+            {
+                stageSlice_ = 0;
+                analysisStage_ = AnalysisStage::spectrum;
+            }
+            return streamCost_;
+        }
+
+        case AnalysisStage::spectrum:
+        {
+            // Final butterfly fused with the magnitude pass and the peak search:
+            // X[k] = E[k] + W^k O[k], mag = |X[k]| / fftSize
+            constexpr int sliceLength = fftSize_ / 2 / spectrumSlices_;
+            const int begin = stageSlice_ * sliceLength;
+
+            const auto getMagnitude = [this](const std::complex<float>* stream, int k)
+            {
+                const int half = k / subFftSize_;
+                const int index = k - half * subFftSize_;
+                const auto bin = stream[(half * 2) * subFftSize_ + index]
+                               + twiddles_[k] * stream[(half * 2 + 1) * subFftSize_ + index];
+
+                return std::sqrt(bin.real() * bin.real() + bin.imag() * bin.imag()) / fftSize_;
+            };
+
+            for (int k = begin; k < begin + sliceLength; ++k)
+            {
+                const float magnitude = getMagnitude(regions, k);
+                fftMagnitudes_[k] = magnitude;
+
+                // Only bins in the search range (never DC or the bin next to it)
+                if (isSearchedBin(k) && magnitude > strongestMagnitude_)
+                {
+                    strongestMagnitude_ = magnitude;
+                    strongestBin_ = k;
+                }
+            }
+
+            // The reference's magnitudes, and how strongly they line up with the input's
+            if (referenceRegions != nullptr)
+            {
+                if (stageSlice_ == 0)
+                {
+                    referenceCorrelation_ = 0.0f;
+                    referenceEnergy_ = 0.0f;
+                }
+
+                for (int k = begin; k < begin + sliceLength; ++k)
+                {
+                    const float magnitude = getMagnitude(referenceRegions, k);
+                    referenceMagnitudes_[k] = magnitude;
+                    referenceCorrelation_ += magnitude * fftMagnitudes_[k];
+                    referenceEnergy_ += magnitude * magnitude;
+                }
+            }
+
+            if (++stageSlice_ == spectrumSlices_)
+            {
+                stageSlice_ = 0;
+                analysisStage_ = getStageAfterSpectrum();
+            }
+            return spectrumSliceCost_ * streamCost_;
+        }
+
+        case AnalysisStage::suppress:
+        {
+            if (stageSlice_ == 0)
+            {
+                // Least-squares fit of the reference magnitudes to the input's. Whatever the
+                // soloist adds can only raise the fit, so lower estimates are trusted at once
+                // and higher ones approached slowly. A silent reference leaves it unchanged.
+                if (referenceEnergy_ > magnitudeThreshold_ * magnitudeThreshold_)
+                {
+                    const float frameGain = referenceCorrelation_ / referenceEnergy_;
+                    bleedGain_ = frameGain < bleedGain_ ? frameGain : bleedGain_ + bleedGainRise_ * (frameGain - bleedGain_);
+                }
+
+                // The peak is picked again from what the accompaniment doesn't account for
+                strongestBin_ = lowestBin_;
+                strongestMagnitude_ = -1.0f;
+            }
+
+            suppressReferenceSlice(stageSlice_ * (fftSize_ / 2) / suppressSlices_,
+                                   (stageSlice_ + 1) * (fftSize_ / 2) / suppressSlices_);
+
+            if (++stageSlice_ == suppressSlices_)
+            {
+                stageSlice_ = 0;
+                analysisStage_ = noiseBins_ != nullptr ? AnalysisStage::denoise
+                               : separationBins_ > 0   ? AnalysisStage::separate
+                                                       : AnalysisStage::chroma;
+            }
+            return 1.0f;
+        }
+
+        case AnalysisStage::denoise:
+        {
+            if (stageSlice_ == 0)
+            {
+                // Learn only from silence: frames whose strongest raw peak doesn't stand out of the
+                // floor (of the absolute threshold until there is one), so notes never join the floor
+                subtractNoise_ = isNoiseProfileLearned();
+                learnNoise_ = subtractNoise_ ? strongestMagnitude_ <= noiseFloorRatio_ * noiseBins_[strongestBin_].getFloor()
+                                             : strongestMagnitude_ <= magnitudeThreshold_;
+
+                // Against the floor, the peak is picked again from what stands out of it
+                if (subtractNoise_)
+                {
+                    strongestBin_ = lowestBin_;
+                    strongestMagnitude_ = -1.0f;
+                }
+            }
+
+            denoiseSlice(stageSlice_ * (fftSize_ / 2) / denoiseSlices_,
+                         (stageSlice_ + 1) * (fftSize_ / 2) / denoiseSlices_);
+
+            if (++stageSlice_ == denoiseSlices_)
+            {
+                stageSlice_ = 0;
+
+                if (learnNoise_)
+                    ++noiseFramesLearned_;
+
+                // Nothing above the floor - skip straight to publishing the silence
+                if (subtractNoise_ && strongestMagnitude_ < 0.0f)
+                {
+                    frameChroma_.fill(0.0f);
+
+                    for (auto& pitchClass : chroma_)
+                        pitchClass *= chromaDecay_;
+
+                    analysisStage_ = AnalysisStage::finish;
+                }
+                else
+                {
+                    analysisStage_ = separationBins_ > 0 ? AnalysisStage::separate : AnalysisStage::chroma;
+                }
+            }
+            return 1.0f;
+        }
+
+        case AnalysisStage::separate:
+        {
+            const auto startTicks = juce::Time::getHighResolutionTicks();
+
+            // The peak is picked again from the harmonic part alone
+            if (stageSlice_ == 0)
+            {
+                strongestBin_ = lowestBin_;
+                strongestMagnitude_ = -1.0f;
+                separationTicks_ = 0;
+            }
+
+            separateHarmonicSlice(stageSlice_ * separationBins_ / separateSlices_,
+                                  (stageSlice_ + 1) * separationBins_ / separateSlices_);
+            separationTicks_ += juce::Time::getHighResolutionTicks() - startTicks;
+
+            if (++stageSlice_ == separateSlices_)
+            {
+                stageSlice_ = 0;
+                analysisStage_ = AnalysisStage::chroma;
+
+                auto worstTicks = worstSeparationTicks_.load(std::memory_order_relaxed);
+                while (separationTicks_ > worstTicks
+                       && !worstSeparationTicks_.compare_exchange_weak(worstTicks, separationTicks_, std::memory_order_relaxed))
+                {
+                }
+            }
+            return 1.0f;
+        }
+
+        case AnalysisStage::chroma:
+        {
+            // Sparse matrix-vector product: at most two pitch classes per bin
+            const int begin = stageSlice_ * numChromaWeights_ / chromaSlices_;
+            const int end = (stageSlice_ + 1) * numChromaWeights_ / chromaSlices_;
+
+            if (stageSlice_ == 0)
+                frameChroma_.fill(0.0f);
+
+            for (int i = begin; i < end; ++i)
+            {
+                const auto& entry = chromaWeights_[i];
+                frameChroma_[static_cast<size_t>(entry.pitchClass)] += entry.weight * fftMagnitudes_[entry.bin];
+            }
+
+            if (++stageSlice_ == chromaSlices_)
+            {
+                stageSlice_ = 0;
+                analysisStage_ = AnalysisStage::finish;
+
+                for (size_t pitchClass = 0; pitchClass < 12; ++pitchClass)
+                    chroma_[pitchClass] = chroma_[pitchClass] * chromaDecay_ + frameChroma_[pitchClass];
+            }
+            return 1.0f;
+        }
+
+        case AnalysisStage::finish:
+            finishFrame();
+            analysisStage_ = AnalysisStage::idle;
+            return 1.0f;
+
+        case AnalysisStage::idle:
+        default:
+            return 0.0f;
+    }
+}
+
+void PitchDetector::splitPackedSpectrum(std::complex<float>* spectrum, std::complex<float>* reference)
+{
+    //==============================================================================
+    // For z = x + i y with x and y real, Z[k] = X[k] + i Y[k], and real signals have
+    // conjugate-symmetric spectra, so with Z*[-k] = conj(Z[(N - k) % N]):
+    // X[k] = (Z[k] + Z*[-k]) / 2 and Y[k] = (Z[k] - Z*[-k]) / 2i.
+    // Bins k and N - k are computed together so the input can be split in place.
+    //==============================================================================
+    for (int k = 0; k <= subFftSize_ / 2; ++k)
     {
-        fftBuffer_[i] *= windowBuffer_[i];
+        const int mirror = (subFftSize_ - k) & (subFftSize_ - 1);
+        const auto z = spectrum[k];
+        const auto zMirror = std::conj(spectrum[mirror]);
+
+        const auto input = 0.5f * (z + zMirror);
+        const auto difference = 0.5f * (z - zMirror);
+        const std::complex<float> referenceBin(difference.imag(), -difference.real());
+
+        spectrum[k] = input;
+        spectrum[mirror] = std::conj(input);
+        reference[k] = referenceBin;
+        reference[mirror] = std::conj(referenceBin);
     }
+}
 
-    // Perform FFT
-    fft_->performRealOnlyForwardTransform(fftBuffer_.getData());
+void PitchDetector::suppressReferenceSlice(int begin, int end)
+{
+    // Power subtraction: phases are unknown, so the bleed is removed on average
+    const float scale = referenceSuppression_ * bleedGain_ * bleedGain_;
 
-    // Calculate magnitude spectrum: mag = sqrt(real² + imag²) / fftSize
-    for (int i = 0; i < fftSize_ / 2; ++i)
+    for (int k = begin; k < end; ++k)
     {
-        float real = fftBuffer_[i * 2];
-        float imag = fftBuffer_[i * 2 + 1];
-        fftMagnitudes_[i] = std::sqrt(real * real + imag * imag) / fftSize_;
+        const float magnitude = fftMagnitudes_[k];
+        const float reference = referenceMagnitudes_[k];
+        const float remaining = std::sqrt(juce::jmax(0.0f, magnitude * magnitude - scale * reference * reference));
+        fftMagnitudes_[k] = remaining;
+
+        if (isSearchedBin(k) && remaining > strongestMagnitude_)
+        {
+            strongestMagnitude_ = remaining;
+            strongestBin_ = k;
+        }
     }
+}
 
-    // Monophonic detection: find the strongest peak in the spectrum
-    candidateNotes_.clear();
+void PitchDetector::denoiseSlice(int begin, int end)
+{
+    //==============================================================================
+    // Minimum statistics: a bin's smoothed magnitude dips to the noise level every
+    // so often, so its minimum over a long enough window tracks the floor. The
+    // window is split into subwindows (Martin's scheme) so each frame costs one
+    // comparison per bin, plus a pass over the subwindow minima when one completes.
+    //==============================================================================
+    const bool firstFrame = noiseFramesLearned_ == 0;
+    const bool endsSubwindow = (noiseFramesLearned_ + 1) % noiseSubwindowFrames_ == 0;
+    const auto subwindow = static_cast<size_t>(noiseFramesLearned_ / noiseSubwindowFrames_ % noiseSubwindows_);
+    const float excessRatio = noiseFloorRatio_ - 1.0f;
 
-    // Skip first 2 bins (DC and very low frequency noise)
-    // Bin 2 = ~21 Hz with 4096 FFT, allowing detection down to ~40 Hz (low E on bass)
-    int strongestBin = 2;
-    float strongestMagnitude = fftMagnitudes_[2];
+    for (int k = begin; k < end; ++k)
+    {
+        auto& bin = noiseBins_[k];
+        const float magnitude = fftMagnitudes_[k];
+
+        if (learnNoise_)
+        {
+            bin.smoothed = firstFrame ? magnitude : bin.smoothed + (1.0f - noiseSmoothing_) * (magnitude - bin.smoothed);
+            bin.subwindowMinimum = juce::jmin(bin.subwindowMinimum, bin.smoothed);
+
+            if (endsSubwindow)
+            {
+                bin.minima[subwindow] = bin.subwindowMinimum;
+                bin.windowMinimum = *std::min_element(bin.minima.begin(), bin.minima.end());
+                bin.subwindowMinimum = bin.smoothed;
+            }
+        }
+
+        if (!subtractNoise_)
+            continue;
+
+        // Spectral subtraction; the peak must clear the floor by noiseFloorRatio_ before it
+        const float floor = bin.getFloor();
+        const float excess = juce::jmax(0.0f, magnitude - floor);
+        fftMagnitudes_[k] = excess;
+
+        if (isSearchedBin(k) && excess > excessRatio * floor && excess > strongestMagnitude_)
+        {
+            strongestMagnitude_ = excess;
+            strongestBin_ = k;
+        }
+    }
+}
+
+void PitchDetector::clearNoiseProfile()
+{
+    noiseFramesLearned_ = 0;
+    subtractNoise_ = false;
+
+    if (noiseBins_ == nullptr)
+        return;
 
-    for (int i = 3; i < fftSize_ / 2; ++i)
+    NoiseBin unlearned;
+    unlearned.subwindowMinimum = std::numeric_limits<float>::max();
+    unlearned.windowMinimum = std::numeric_limits<float>::max();
+    unlearned.minima.fill(std::numeric_limits<float>::max());
+    std::fill(noiseBins_, noiseBins_ + fftSize_ / 2, unlearned);
+}
+
+void PitchDetector::separateHarmonicSlice(int begin, int end)
+{
+    //==============================================================================
+    // Median filtering HPSS: sustained tones are smooth along time and peaky along
+    // frequency, attacks and noise the other way round. H = median of the bin over
+    // the last timeMedianFrames_ frames, P = median over frequencyMedianBins_ bins
+    // around it, and the bin keeps its harmonic share mag * H^2 / (H^2 + P^2).
+    // Both medians slide, so each bin costs two O(log n) updates and no sort.
+    //==============================================================================
+    constexpr int halfWidth = frequencyMedianBins_ / 2;
+    constexpr int lastBin = fftSize_ / 2 - 1;
+
+    // Bins below 0 repeat bin 0; the window is completed by the first push below
+    if (begin == 0)
     {
-        if (fftMagnitudes_[i] > strongestMagnitude)
+        frequencyMedian_.fill(fftMagnitudes_[0]);
+
+        for (int k = 1; k < halfWidth; ++k)
+            frequencyMedian_.push(fftMagnitudes_[k]);
+    }
+
+    for (int k = begin; k < end; ++k)
+    {
+        // Bins ahead of k still hold raw magnitudes; those behind it were already separated
+        frequencyMedian_.push(fftMagnitudes_[juce::jmin(k + halfWidth, lastBin)]);
+
+        const float magnitude = fftMagnitudes_[k];
+        auto& timeMedian = timeMedians_[k];
+        timeMedian.push(magnitude);
+
+        const float harmonic = timeMedian.getMedian();
+        const float percussive = frequencyMedian_.getMedian();
+        const float harmonicPower = harmonic * harmonic;
+        const float totalPower = harmonicPower + percussive * percussive;
+        const float separated = totalPower > 0.0f ? magnitude * harmonicPower / totalPower : 0.0f;
+        fftMagnitudes_[k] = separated;
+
+        if (isSearchedBin(k) && separated > strongestMagnitude_)
         {
-            strongestMagnitude = fftMagnitudes_[i];
-            strongestBin = i;
+            strongestMagnitude_ = separated;
+            strongestBin_ = k;
         }
     }
+}
+
+void PitchDetector::clearTimeMedians()
+{
+    for (int k = 0; k < separationBins_; ++k)
+        timeMedians_[k].fill(0.0f);
+}
+
+float PitchDetector::refinePeak(int bin) const
+{
+    float refinedPeakIndex = static_cast<float>(bin);
 
-    // Only process if magnitude is above threshold
-    if (strongestMagnitude > magnitudeThreshold_)
+    if (bin > 0 && bin < fftSize_ / 2 - 1)
     {
-        // Parabolic interpolation for sub-bin accuracy
-        float refinedPeakIndex = static_cast<float>(strongestBin);
+        float left = fftMagnitudes_[bin - 1];
+        float center = fftMagnitudes_[bin];
+        float right = fftMagnitudes_[bin + 1];
 
-        if (strongestBin > 0 && strongestBin < fftSize_ / 2 - 1)
+        // Parabolic interpolation: delta = 0.5 * (left - right) / (left - 2*center + right)
+        float denominator = left - 2.0f * center + right;
+        if (std::abs(denominator) > 0.0001f)
         {
-            float left = fftMagnitudes_[strongestBin - 1];
-            float center = fftMagnitudes_[strongestBin];
-            float right = fftMagnitudes_[strongestBin + 1];
+            float delta = 0.5f * (left - right) / denominator;
+            refinedPeakIndex = bin + delta;
+        }
+    }
 
-            // Parabolic interpolation: delta = 0.5 * (left - right) / (left - 2*center + right)
-            float denominator = left - 2.0f * center + right;
-            if (std::abs(denominator) > 0.0001f)
-            {
-                float delta = 0.5f * (left - right) / denominator;
-                refinedPeakIndex = strongestBin + delta;
-            }
+    return refinedPeakIndex;
+}
+
+bool PitchDetector::isInSearchRange(float bin) const
+{
+    const float frequency = bin * static_cast<float>(sampleRate_) / fftSize_;
+    return frequency >= searchLowestHz_ && (searchHighestHz_ <= 0.0f || frequency <= searchHighestHz_);
+}
+
+void PitchDetector::findStrongestPeakInRange()
+{
+    strongestBin_ = lowestBin_;
+    strongestMagnitude_ = -1.0f;
+
+    for (int k = lowestBin_ + 1; k < highestBin_; ++k)
+    {
+        const float magnitude = fftMagnitudes_[k];
+
+        if (magnitude > strongestMagnitude_ && magnitude > fftMagnitudes_[k - 1] && magnitude >= fftMagnitudes_[k + 1])
+        {
+            strongestMagnitude_ = magnitude;
+            strongestBin_ = k;
         }
+    }
+}
+
+void PitchDetector::finishFrame()
+{
+    //==============================================================================
+    // Simple Monophonic Pitch Detection:
+    // 1. Find the strongest frequency peak in the FFT spectrum (done in the spectrum stage)
+    // 2. Use parabolic interpolation for sub-bin accuracy
+    // 3. Map the frequency to a note using predefined frequency ranges
+    // 4. No harmonic filtering - the loudest frequency is the detected note
+    //==============================================================================
+
+    numCandidateNotes_ = 0;
+
+    // Parabolic interpolation for sub-bin accuracy
+    float refinedPeakIndex = refinePeak(strongestBin_);
+
+    // A narrowed search range can end on the slope of a peak outside it - take the strongest one inside instead
+    if (!isInSearchRange(refinedPeakIndex))
+    {
+        findStrongestPeakInRange();
+        refinedPeakIndex = refinePeak(strongestBin_);
+    }
 
+    // Bin 2 = ~21 Hz with 4096 FFT, allowing detection down to ~40 Hz (low E on bass)
+    const int strongestBin = strongestBin_;
+    const float strongestMagnitude = strongestMagnitude_;
+
+    // Only process if magnitude is above threshold - relative to the noise floor once learned
+    const float threshold = subtractNoise_ ? (noiseFloorRatio_ - 1.0f) * noiseBins_[strongestBin].getFloor()
+                                           : magnitudeThreshold_;
+
+    if (strongestMagnitude > threshold)
+    {
         // Convert bin to frequency
         float frequency = refinedPeakIndex * static_cast<float>(sampleRate_) / fftSize_;
 
         // Look up which note this frequency belongs to
-        const auto* noteRange = findNoteForFrequency(frequency);
+        const auto* noteRange = tables_->findNoteForFrequency(frequency);
 
         if (noteRange != nullptr)
         {
-            DetectedNote note;
-            note.noteName = noteRange->noteName;
+            auto& note = candidateNotes_[numCandidateNotes_++];
             note.frequency = frequency;
             note.magnitude = strongestMagnitude;
             note.midiNoteNumber = noteRange->midiNoteNumber;
-
-            candidateNotes_.push_back(note);
         }
     }
 
     // Apply note stability tracking
     updateNoteStability();
+    publishFrame(frameEndSample_);
+
+    if (firstResultTicks_.load(std::memory_order_relaxed) == 0)
+        firstResultTicks_.store(juce::Time::getHighResolutionTicks() - constructionTicks_, std::memory_order_relaxed);
 }
 
 void PitchDetector::updateNoteStability()
 {
+    const NoteCandidate* candidatesBegin = candidateNotes_;
+    const NoteCandidate* candidatesEnd = candidatesBegin + numCandidateNotes_;
+    auto* historyEnd = noteHistory_ + numHistoryEntries_;
+
     // Update history for each candidate note
-    for (const auto& candidate : candidateNotes_)
+    for (const auto* candidate = candidatesBegin; candidate != candidatesEnd; ++candidate)
     {
         // Find if this note exists in history
-        auto it = std::find_if(noteHistory_.begin(), noteHistory_.end(),
-            [&candidate](const NoteHistory& h) { return h.midiNote == candidate.midiNoteNumber; });
+        auto* it = std::find_if(noteHistory_, historyEnd,
+            [candidate](const NoteHistory& h) { return h.midiNote == candidate->midiNoteNumber; });
 
-        if (it != noteHistory_.end())
+        if (it != historyEnd)
         {
             // Note is continuing - increment counter
             it->consecutiveFrames++;
-            it->totalMagnitude += candidate.magnitude;
+            it->totalMagnitude += candidate->magnitude;
         }
         else
         {
-            // New note - add to history
+            // New note - add to history (capacity covers previous + current candidates)
             NoteHistory newHistory;
-            newHistory.midiNote = candidate.midiNoteNumber;
+            newHistory.midiNote = candidate->midiNoteNumber;
             newHistory.consecutiveFrames = 1;
-            newHistory.totalMagnitude = candidate.magnitude;
-            noteHistory_.push_back(newHistory);
+            newHistory.totalMagnitude = candidate->magnitude;
+            *historyEnd++ = newHistory;
         }
     }
 
     // Decay/remove notes not in current candidates
-    for (auto it = noteHistory_.begin(); it != noteHistory_.end();)
+    historyEnd = std::remove_if(noteHistory_, historyEnd, [candidatesBegin, candidatesEnd](const NoteHistory& h)
     {
-        bool stillPresent = std::any_of(candidateNotes_.begin(), candidateNotes_.end(),
-            [&it](const DetectedNote& note) { return note.midiNoteNumber == it->midiNote; });
-
-        if (!stillPresent)
-        {
-            // Note disappeared - remove from history
-            it = noteHistory_.erase(it);
-        }
-        else
-        {
-            ++it;
-        }
-    }
+        return std::none_of(candidatesBegin, candidatesEnd,
+            [&h](const NoteCandidate& note) { return note.midiNoteNumber == h.midiNote; });
+    });
+    numHistoryEntries_ = static_cast<int>(historyEnd - noteHistory_);
 
     // Build stable detectedNotes_ from history
-    detectedNotes_.clear();
-    for (const auto& history : noteHistory_)
+    numDetectedNotes_ = 0;
+    for (const auto* history = noteHistory_; history != historyEnd; ++history)
     {
         // Only report notes that have been stable for required frames
-        if (history.consecutiveFrames >= stabilityFramesRequired_)
+        if (history->consecutiveFrames >= stabilityFramesRequired_)
         {
             // Find the actual note in candidates to get current frequency/magnitude
-            auto candidateIt = std::find_if(candidateNotes_.begin(), candidateNotes_.end(),
-                [&history](const DetectedNote& note) { return note.midiNoteNumber == history.midiNote; });
+            const auto* candidateIt = std::find_if(candidatesBegin, candidatesEnd,
+                [history](const NoteCandidate& note) { return note.midiNoteNumber == history->midiNote; });
 
-            if (candidateIt != candidateNotes_.end())
+            if (candidateIt != candidatesEnd)
             {
-                detectedNotes_.push_back(*candidateIt);
+                detectedNotes_[numDetectedNotes_++] = *candidateIt;
             }
         }
     }
 
-    // Sort by magnitude
-    std::sort(detectedNotes_.begin(), detectedNotes_.end());
+    // Sort by magnitude (descending)
+    std::sort(detectedNotes_, detectedNotes_ + numDetectedNotes_,
+        [](const NoteCandidate& a, const NoteCandidate& b) { return a.magnitude > b.magnitude; });
+}
+
+void PitchDetector::publishFrame(juce::int64 frameEndSample)
+{
+    latestFrame_.midiNoteNumber = numDetectedNotes_ > 0 ? detectedNotes_[0].midiNoteNumber : -1;
+    latestFrame_.frequency = numDetectedNotes_ > 0 ? detectedNotes_[0].frequency : 0.0f;
+    latestFrame_.magnitude = numDetectedNotes_ > 0 ? detectedNotes_[0].magnitude : 0.0f;
+    latestFrame_.centsOffset = numDetectedNotes_ > 0
+        ? 1200.0f * std::log2(latestFrame_.frequency / midiNoteToFrequency(latestFrame_.midiNoteNumber))
+        : 0.0f;
+    latestFrame_.frameEndSample = frameEndSample;
+    latestFrame_.sourceChannel = sourceChannel_;
+    latestFrame_.frameChroma = frameChroma_;
+    latestFrame_.chroma = chroma_;
+    ++latestFrame_.frameIndex;
+    recentFrames_[static_cast<size_t>(latestFrame_.frameIndex % maxRecentFrames)] = latestFrame_;
+
+    publishDetectedNotes();
+}
+
+void PitchDetector::publishDetectedNotes()
+{
+    // One writer; readers retry if the sequence was odd or moved while they copied
+    const auto sequence = publishedSequence_.load(std::memory_order_relaxed);
+    publishedSequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (int i = 0; i < numDetectedNotes_; ++i)
+    {
+        auto& published = publishedNotes_[static_cast<size_t>(i)];
+        published.midiNoteNumber.store(detectedNotes_[i].midiNoteNumber, std::memory_order_relaxed);
+        published.frequency.store(detectedNotes_[i].frequency, std::memory_order_relaxed);
+        published.magnitude.store(detectedNotes_[i].magnitude, std::memory_order_relaxed);
+    }
+
+    numPublishedNotes_.store(numDetectedNotes_, std::memory_order_relaxed);
+    publishedChannel_.store(sourceChannel_, std::memory_order_relaxed);
+    publishedSequence_.store(sequence + 2, std::memory_order_release);
 }
 
 std::vector<DetectedNote> PitchDetector::getDetectedNotes() const
 {
-    return detectedNotes_;
+    std::array<NoteCandidate, maxNotes_> copy;
+    int numNotes = 0;
+    int channel = 0;
+
+    for (;;)
+    {
+        const auto sequence = publishedSequence_.load(std::memory_order_acquire);
+
+        if ((sequence & 1) == 0)
+        {
+            numNotes = juce::jlimit(0, maxNotes_, numPublishedNotes_.load(std::memory_order_relaxed));
+            channel = publishedChannel_.load(std::memory_order_relaxed);
+
+            for (int i = 0; i < numNotes; ++i)
+            {
+                const auto& published = publishedNotes_[static_cast<size_t>(i)];
+                copy[static_cast<size_t>(i)] = { published.midiNoteNumber.load(std::memory_order_relaxed),
+                                                 published.frequency.load(std::memory_order_relaxed),
+                                                 published.magnitude.load(std::memory_order_relaxed) };
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (publishedSequence_.load(std::memory_order_relaxed) == sequence)
+                break;
+        }
+
+        juce::Thread::yield();
+    }
+
+    std::vector<DetectedNote> notes;
+    notes.reserve(static_cast<size_t>(numNotes));
+
+    for (int i = 0; i < numNotes; ++i)
+    {
+        const auto& detected = copy[static_cast<size_t>(i)];
+        notes.push_back({ midiNoteToName(detected.midiNoteNumber), detected.frequency,
+                          detected.magnitude, detected.midiNoteNumber, channel });
+    }
+
+    return notes;
+}
+
+void PitchDetector::detachWorkingMemory()
+{
+    preFilterBuffer_ = nullptr;
+    fftBuffer_ = nullptr;
+    fftMagnitudes_ = nullptr;
+    referenceBuffer_ = nullptr;
+    referenceMagnitudes_ = nullptr;
+    noiseBins_ = nullptr;
+    timeMedians_ = nullptr;
+    candidateNotes_ = nullptr;
+    detectedNotes_ = nullptr;
+    noteHistory_ = nullptr;
+    frameData_ = nullptr;
+    referenceFrameData_ = nullptr;
+    inputRing_.attach(nullptr, fftSize_ * 2);
+    referenceRing_.attach(nullptr, fftSize_ * 2);
+
+    analysisStage_ = AnalysisStage::idle;
+    numDetectedNotes_ = 0;
+    numCandidateNotes_ = 0;
+    numHistoryEntries_ = 0;
+    publishDetectedNotes();
 }
 
 void PitchDetector::reset()
 {
-    juce::zeromem(fftBuffer_.getData(), fftSize_ * 2 * sizeof(float));
-    juce::zeromem(fftMagnitudes_.getData(), fftSize_ * sizeof(float));
-    std::fill(fifoBuffer_.begin(), fifoBuffer_.end(), 0.0f);
-    fifo_.reset();
-    detectedNotes_.clear();
-    candidateNotes_.clear();
-    noteHistory_.clear();
+    analysisStage_ = AnalysisStage::idle;
+    stageSlice_ = 0;
+    sliceCredit_ = 0.0f;
+    pendingSamples_ = 0;
+    streamPosition_ = 0;
+    ringStreamPosition_ = 0;
+    latestFrame_ = {};
+    recentFrames_.fill({});
+    inputLevel_ = 0.0f;
+    numDetectedNotes_ = 0;
+    numCandidateNotes_ = 0;
+    numHistoryEntries_ = 0;
+    publishDetectedNotes();
+    frameChroma_.fill(0.0f);
+    chroma_.fill(0.0f);
+    preFilter_.reset();
+    bleedGain_ = 0.0f;
     isActive_.store(false, std::memory_order_relaxed);
+
+    if (arena_.isAllocated())
+    {
+        juce::zeromem(fftBuffer_, fftSize_ * 2 * sizeof(float));
+        juce::zeromem(fftMagnitudes_, fftSize_ / 2 * sizeof(float));
+        clearTimeMedians();
+        clearNoiseProfile();
+        inputRing_.clear();
+
+        if (referenceBuffer_ != nullptr)
+        {
+            juce::zeromem(referenceBuffer_, fftSize_ * 2 * sizeof(float));
+            juce::zeromem(referenceMagnitudes_, fftSize_ / 2 * sizeof(float));
+            referenceRing_.clear();
+        }
+    }
 }
 
 void PitchDetector::setMagnitudeThreshold(float threshold)
@@ -257,43 +1058,63 @@ void PitchDetector::setNoiseGateThreshold(float threshold)
     noiseGateThreshold_ = juce::jlimit(0.0f, 1.0f, threshold);
 }
 
-//==============================================================================
-void PitchDetector::initializeFrequencyMap()
+void PitchDetector::setChromaHalfLife(float seconds)
 {
-    // Create frequency ranges for notes from C1 (MIDI 24, ~33 Hz) to C7 (MIDI 96)
-    // This covers bass guitars (low E = 41 Hz), pianos, and most instruments
-    frequencyMap_.clear();
+    // One frame is analysed per fftSize_ samples of input
+    chromaHalfLifeSeconds_ = juce::jmax(0.01f, seconds);
+    const double frameSeconds = fftSize_ / sampleRate_;
+    chromaDecay_ = static_cast<float>(std::exp2(-frameSeconds / chromaHalfLifeSeconds_));
+}
 
-    for (int midiNote = 24; midiNote <= 96; ++midiNote)
-    {
-        NoteFrequencyRange range;
-        range.midiNoteNumber = midiNote;
-        range.noteName = midiNoteToName(midiNote);
-        range.centerFrequency = midiNoteToFrequency(midiNote);
+void PitchDetector::setFrequencyRange(float lowestHz, float highestHz)
+{
+    searchLowestHz_ = juce::jmax(0.0f, lowestHz);
+    searchHighestHz_ = juce::jmax(0.0f, highestHz);
+}
+
+void PitchDetector::setNoiseFloorRatio(float ratio)
+{
+    noiseFloorRatio_ = juce::jmax(1.0f, ratio);
+}
 
-        // Calculate boundaries as geometric mean between adjacent notes
-        float lowerNoteFreq = midiNoteToFrequency(midiNote - 1);
-        float upperNoteFreq = midiNoteToFrequency(midiNote + 1);
+void PitchDetector::setReferenceSuppression(float amount)
+{
+    referenceSuppression_ = juce::jmax(0.0f, amount);
+}
 
-        range.minFrequency = std::sqrt(lowerNoteFreq * range.centerFrequency);
-        range.maxFrequency = std::sqrt(range.centerFrequency * upperNoteFreq);
+void PitchDetector::setAmortisedAnalysisEnabled(bool shouldAmortise)
+{
+    amortiseAnalysis_ = shouldAmortise;
+}
 
-        frequencyMap_.push_back(range);
-    }
+double PitchDetector::getWorstCaseCallbackMicros() const
+{
+    return juce::Time::highResolutionTicksToSeconds(worstCallbackTicks_.load(std::memory_order_relaxed)) * 1.0e6;
 }
 
-const PitchDetector::NoteFrequencyRange* PitchDetector::findNoteForFrequency(float frequency) const
+double PitchDetector::getWorstCaseSeparationMicros() const
 {
-    for (const auto& range : frequencyMap_)
-    {
-        if (frequency >= range.minFrequency && frequency < range.maxFrequency)
-        {
-            return &range;
-        }
-    }
-    return nullptr;  // Frequency out of range
+    return juce::Time::highResolutionTicksToSeconds(worstSeparationTicks_.load(std::memory_order_relaxed)) * 1.0e6;
+}
+
+void PitchDetector::resetCallbackTimingStats()
+{
+    worstCallbackTicks_.store(0, std::memory_order_relaxed);
+    worstSeparationTicks_.store(0, std::memory_order_relaxed);
+}
+
+PitchDetector::StartupTimings PitchDetector::getStartupTimings() const
+{
+    StartupTimings timings;
+    timings.prepareMicros = juce::Time::highResolutionTicksToSeconds(prepareTicks_.load(std::memory_order_relaxed)) * 1.0e6;
+
+    if (const auto firstResult = firstResultTicks_.load(std::memory_order_relaxed); firstResult != 0)
+        timings.constructToFirstResultMicros = juce::Time::highResolutionTicksToSeconds(firstResult) * 1.0e6;
+
+    return timings;
 }
 
+//==============================================================================
 int PitchDetector::frequencyToMidiNote(float frequency) const
 {
     if (frequency <= 0.0f)
@@ -317,7 +1138,7 @@ juce::String PitchDetector::midiNoteToName(int midiNote) const
     int noteIndex = midiNote % 12;
 
     // Return just the note name without octave number
-    return noteNames_[noteIndex];
+    return CompileTimeTables::noteNames[static_cast<size_t>(noteIndex)];
 }
 
 float PitchDetector::midiNoteToFrequency(int midiNote) const
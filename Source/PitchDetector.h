@@ -2,10 +2,17 @@
 
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_dsp/juce_dsp.h>
+#include "DetectorArena.h"
+#include "MirroredRingBuffer.h"
+#include "PreFilter.h"
+#include "SharedAnalysisTables.h"
+#include "SlidingMedian.h"
 #include <vector>
 #include <array>
 #include <algorithm>
 #include <cmath>
+#include <complex>
+#include <limits>
 
 //==============================================================================
 /**
@@ -17,6 +24,7 @@ struct DetectedNote
     float frequency;           ///< Frequency in Hz
     float magnitude;           ///< Strength/loudness of the frequency
     int midiNoteNumber;        ///< MIDI note number (0-127)
+    int channel = 0;           ///< Input channel it was detected on, or -1 for a mix of channels
 
     /** Compare notes by magnitude for sorting (descending order). */
     bool operator<(const DetectedNote& other) const
@@ -40,19 +48,12 @@ public:
     PitchDetector();
     ~PitchDetector() = default;
 
-    /** Frequency range mapping for a musical note. */
-    struct NoteFrequencyRange
-    {
-        juce::String noteName;
-        float minFrequency;
-        float maxFrequency;
-        float centerFrequency;
-        int midiNoteNumber;
-    };
+    using WindowType = SharedAnalysisTables::WindowType;
 
     //==============================================================================
     /**
      * Prepares the pitch detector for audio processing.
+     * Acquires the shared tables and lays out all working memory. Not real-time safe.
      *
      * @param sampleRate        Audio sample rate in Hz
      * @param expectedBlockSize Maximum samples per audio block
@@ -63,19 +64,132 @@ public:
      * Processes an audio block for pitch detection.
      * Must be called from the audio thread.
      *
-     * @param audioData  Pointer to mono audio samples
-     * @param numSamples Number of samples in buffer
+     * @param audioData     Pointer to mono audio samples
+     * @param numSamples    Number of samples in buffer
+     * @param referenceData Accompaniment reference for the same samples, or nullptr
+     *                      for none (only used when the reference input is enabled)
      */
-    void processAudioBlock(const float* audioData, int numSamples);
+    void processAudioBlock(const float* audioData, int numSamples, const float* referenceData = nullptr);
 
     /**
      * Gets currently detected notes, sorted by strength.
-     * Thread-safe - can be called from GUI thread.
+     * Reads a copy published with each frame, outside the working memory, so
+     * the GUI thread may call it at any time, including during prepare().
+     * Allocates, so never from the audio thread (use getLatestFrame() there).
      *
      * @return Vector of detected notes
      */
     std::vector<DetectedNote> getDetectedNotes() const;
 
+    /** Latest analysis result in a form the audio thread can read without allocating. */
+    struct FrameResult
+    {
+        int midiNoteNumber = -1;           ///< Strongest stable note, or -1 for none
+        float frequency = 0.0f;            ///< Refined frequency in Hz
+        float centsOffset = 0.0f;          ///< Deviation of frequency from the note's equal-tempered pitch
+        float magnitude = 0.0f;            ///< Peak magnitude
+        juce::int64 frameEndSample = 0;    ///< Stream position just past the frame's last sample
+        juce::uint32 frameIndex = 0;       ///< Increments whenever a new result is published
+        int sourceChannel = 0;             ///< Input channel analysed, or -1 for a mix (see setSourceChannel())
+        std::array<float, 12> frameChroma {}; ///< This frame's spectral magnitude per pitch class (C = 0)
+        std::array<float, 12> chroma {};   ///< frameChroma accumulated with decay (see setChromaHalfLife())
+    };
+
+    /**
+     * Gets the latest analysis result.
+     * Must be called from the audio thread (the thread calling processAudioBlock).
+     */
+    const FrameResult& getLatestFrame() const { return latestFrame_; }
+
+    /** Results kept for getFrame(): enough for every frame of a block of about seven frames. */
+    static constexpr int maxRecentFrames = 8;
+
+    /**
+     * Gets a recently published result, for callers that must see every frame
+     * even when one processAudioBlock() call publishes several.
+     * Must be called from the audio thread.
+     *
+     * @param frameIndex One of the last maxRecentFrames frame indices published
+     */
+    const FrameResult& getFrame(juce::uint32 frameIndex) const
+    {
+        return recentFrames_[static_cast<size_t>(frameIndex % maxRecentFrames)];
+    }
+
+    /** Gets the number of samples passed to processAudioBlock() since prepare(). */
+    juce::int64 getStreamPosition() const { return streamPosition_; }
+
+    /**
+     * Gets the worst-case number of samples between a note starting and the end
+     * of the frame that first reports it (one partial frame plus the stability frames,
+     * plus the frames the time median needs to accept a new note when separating).
+     */
+    int getDetectionLatencySamples() const
+    {
+        return fftSize_ * (stabilityFramesRequired_ + 1 + (separationBins_ > 0 ? timeMedianFrames_ / 2 : 0))
+             + preFilter_.getLatencySamples();
+    }
+
+    /**
+     * Sets the input channel results are tagged with, for callers analysing
+     * more than one channel or switching between them. Applies to results
+     * published from then on.
+     *
+     * @param channel Input channel index, or -1 for a mix of channels
+     */
+    void setSourceChannel(int channel) { sourceChannel_ = channel; }
+
+    //==============================================================================
+    /**
+     * Hands the transform of each frame to the caller, for owners analysing
+     * several detectors' frames in one batch (see BatchedFFT).
+     *
+     * A frame that completes during processAudioBlock() then waits, unanalysed,
+     * until its magnitudes are passed to completeBatchFrame(); the stages after the
+     * transform then run as they otherwise would, spread over the following callbacks
+     * when analysis is amortised. Blocks must be at most getFFTSize() samples, with any
+     * waiting frame completed in between; a frame still waiting when the input ring
+     * fills up is transformed by the detector itself. Frames analysed with the
+     * reference input always are. Takes effect from the next frame.
+     *
+     * @param shouldBatch true to leave each frame's transform to the caller
+     */
+    void setBatchedTransformEnabled(bool shouldBatch) { batchTransform_ = shouldBatch; }
+
+    /**
+     * Gets the frame waiting for its spectrum (audio thread).
+     *
+     * @return getFFTSize() pre-filtered, unwindowed samples, or nullptr if no frame is waiting
+     */
+    const float* getBatchFrame() const { return analysisStage_ == AnalysisStage::batch ? frameData_ : nullptr; }
+
+    /**
+     * Supplies the waiting frame's magnitude spectrum (audio thread). The rest of
+     * the frame is analysed by the following processAudioBlock() calls, or here
+     * if amortised analysis is off.
+     *
+     * @param magnitudes         |X[k]| / getFFTSize() for the getFFTSize() / 2 bins, spaced stride apart
+     * @param stride             Distance between consecutive bins in magnitudes
+     * @param strongestBin       Strongest bin within getLowestSearchedBin() to getHighestSearchedBin()
+     * @param strongestMagnitude Magnitude of strongestBin
+     */
+    void completeBatchFrame(const float* magnitudes, int stride, int strongestBin, float strongestMagnitude);
+
+    /** Gets the first bin the peak is searched in (fixed by prepare()). */
+    int getLowestSearchedBin() const { return lowestBin_; }
+
+    /** Gets the last bin the peak is searched in (fixed by prepare()). */
+    int getHighestSearchedBin() const { return highestBin_; }
+
+    /** Gets log2 of the analysis frame size. */
+    static constexpr int getFFTOrder() { return fftOrder_; }
+
+    /** Gets the analysis frame size (and the hop between frames). */
+    static constexpr int getFFTSize() { return fftSize_; }
+
+    /** Gets the RMS level of the last block passed to processAudioBlock() (audio thread). */
+    float getInputLevel() const { return inputLevel_; }
+
     /**
      * Resets all internal buffers and state.
      */
@@ -102,10 +216,303 @@ public:
      */
     void setNoiseGateThreshold(float threshold);
 
+    /**
+     * Sets the analysis window shape. Takes effect on the next prepare().
+     *
+     * @param type Window applied to each frame before the FFT
+     */
+    void setWindowType(WindowType type) { windowType_ = type; }
+
+    /** Gets the analysis window shape set for the next prepare(). */
+    WindowType getWindowType() const { return windowType_; }
+
+    /**
+     * Sets the IIR clean-up applied to the input before analysis: a rumble
+     * high-pass and mains hum notches. Both are off by default: rumble sits
+     * below the lowest note searched, and the mains frequency depends on the
+     * region. Takes effect on the next prepare().
+     *
+     * @param settings Filter chain to build
+     */
+    void setPreFilterSettings(const PreFilter::Settings& settings) { preFilterSettings_ = settings; }
+
+    /**
+     * Narrows the range the strongest peak is searched in, e.g. to one string's
+     * range on a divided pickup, so that partials and crosstalk outside it
+     * can't be picked. The chroma still covers the whole spectrum.
+     * Takes effect on the next prepare().
+     *
+     * @param lowestHz  Lowest frequency searched (nothing below ~21 Hz is ever searched)
+     * @param highestHz Highest frequency searched, or 0 for no limit
+     */
+    void setFrequencyRange(float lowestHz, float highestHz);
+
+    /**
+     * Sets how quickly the accumulated chroma forgets earlier frames.
+     *
+     * @param seconds Time for a frame's contribution to halve
+     */
+    void setChromaHalfLife(float seconds);
+
+    /**
+     * Enables harmonic/percussive separation ahead of peak picking.
+     *
+     * Each bin's magnitude is compared with its median over the last few frames
+     * (sustained, harmonic energy) and over neighbouring bins (broadband,
+     * percussive energy), and only its harmonic share is kept. Pick attacks,
+     * strums and drum bleed then stop producing spurious peaks, at the cost of
+     * one extra frame before a new note's peak reaches full strength.
+     * Takes effect on the next prepare().
+     *
+     * @param shouldSeparate true to pick peaks from the harmonic spectrum only
+     */
+    void setHarmonicSeparationEnabled(bool shouldSeparate) { separateHarmonics_ = shouldSeparate; }
+
+    /** Returns true if peaks are currently picked from the harmonic spectrum. */
+    bool isHarmonicSeparationActive() const { return separationBins_ > 0; }
+
+    /**
+     * Enables the learned noise profile.
+     *
+     * The background noise spectrum is learned by minimum statistics from
+     * frames with nothing standing out of it, and subtracted from every frame
+     * before peak picking. Once learned, a peak must exceed the noise floor at
+     * its bin by setNoiseFloorRatio() instead of the absolute magnitude
+     * threshold, and frames with no such peak skip separation, chroma and note
+     * lookup. Until then the magnitude threshold applies as usual.
+     * Takes effect on the next prepare().
+     *
+     * @param shouldUseProfile true to learn and subtract the noise floor
+     */
+    void setNoiseProfileEnabled(bool shouldUseProfile) { useNoiseProfile_ = shouldUseProfile; }
+
+    /** Returns true if the noise floor has been learned and thresholds are relative to it. */
+    bool isNoiseProfileLearned() const { return noiseBins_ != nullptr && noiseFramesLearned_ >= noiseWindowFrames_; }
+
+    /**
+     * Sets how far a peak must rise above the learned noise floor to be detected.
+     *
+     * @param ratio Peak to noise floor magnitude ratio (e.g. 4 = 12 dB)
+     */
+    void setNoiseFloorRatio(float ratio);
+
+    /**
+     * Enables the accompaniment reference input.
+     *
+     * The reference (e.g. the backing track feeding the monitors) is analysed
+     * alongside the input and its spectrum, scaled to the level at which it
+     * bleeds into the input, is power-subtracted before peak picking. Both signals
+     * share each sub-transform as the real and imaginary parts of one complex
+     * FFT, so the reference costs extra butterflies but no extra FFTs.
+     * Takes effect on the next prepare().
+     *
+     * @param shouldUseReference true to analyse and subtract the reference
+     */
+    void setReferenceInputEnabled(bool shouldUseReference) { useReference_ = shouldUseReference; }
+
+    /** Returns true if the reference input is analysed and subtracted. */
+    bool isReferenceInputActive() const { return referenceBuffer_ != nullptr; }
+
+    /**
+     * Sets how much of the reference is subtracted, relative to its estimated
+     * bleed into the input. Values above 1 over-subtract to cover room colouration.
+     *
+     * @param amount Over-subtraction factor in power (default 2 = 3 dB; 0 leaves the input untouched)
+     */
+    void setReferenceSuppression(float amount);
+
+    /** Gets the current estimate of the reference's level in the input (audio thread). */
+    float getReferenceBleedGain() const { return bleedGain_; }
+
+    //==============================================================================
+    /**
+     * Enables or disables amortised analysis.
+     *
+     * When enabled, the window/FFT/magnitude/peak work for a frame is split into
+     * bounded slices that are spread over the callbacks following the one that
+     * completed the frame, instead of running all at once.
+     *
+     * @param shouldAmortise true to spread analysis work across callbacks
+     */
+    void setAmortisedAnalysisEnabled(bool shouldAmortise);
+
+    /** Returns true if analysis work is spread across callbacks. */
+    bool isAmortisedAnalysisEnabled() const { return amortiseAnalysis_; }
+
+    /**
+     * Gets the number of samples between a frame completing and its result
+     * being published (0 when amortisation is disabled).
+     */
+    int getAnalysisSpreadSamples() const { return amortiseAnalysis_ ? analysisSpreadSamples_ : 0; }
+
+    /**
+     * Gets the longest processAudioBlock() call since the last reset.
+     *
+     * @return Worst-case callback time in microseconds
+     */
+    double getWorstCaseCallbackMicros() const;
+
+    /**
+     * Gets the most time harmonic separation has added to one frame since the
+     * last reset. The work is a fixed number of bins times two O(log n) median
+     * updates, spread over slices like the other stages.
+     *
+     * @return Worst-case separation time per frame in microseconds
+     */
+    double getWorstCaseSeparationMicros() const;
+
+    /** Clears the worst-case callback and separation time metrics. */
+    void resetCallbackTimingStats();
+
+    //==============================================================================
+    /**
+     * Enables locking the working memory into physical RAM.
+     * Takes effect on the next prepare(). Locking is best-effort: the OS may
+     * refuse it (e.g. RLIMIT_MEMLOCK), in which case the memory stays pageable.
+     *
+     * @param shouldLock true to mlock/VirtualLock the working arena
+     */
+    void setMemoryLockingEnabled(bool shouldLock) { lockMemory_ = shouldLock; }
+
+    /** Returns true if the working memory is currently locked. */
+    bool isMemoryLocked() const { return arena_.isLocked(); }
+
+    /**
+     * Gets the memory owned by this instance: the object itself plus its
+     * working arena. Tables shared with other instances, and the FFT
+     * engine's internals, are not included.
+     *
+     * @return Footprint in bytes
+     */
+    size_t getMemoryFootprintBytes() const { return sizeof(*this) + arena_.getAllocatedBytes(); }
+
+    //==============================================================================
+    /** Instantiation cost measurements, for profiling plugin scans and session loads. */
+    struct StartupTimings
+    {
+        double prepareMicros = 0.0;                    ///< Time spent in the last prepare()
+        double constructToFirstResultMicros = -1.0;    ///< Construction until the first analysed frame (-1 until then)
+    };
+
+    /** Gets the startup timings measured so far. */
+    StartupTimings getStartupTimings() const;
+
 private:
     //==============================================================================
-    /** Performs FFT analysis on accumulated audio buffer. */
-    void performFFTAnalysis();
+    /** Analysis stages of a frame, each split into bounded slices. */
+    enum class AnalysisStage
+    {
+        idle,       ///< No frame in flight
+        batch,      ///< Waiting for the caller to supply the frame's spectrum (see setBatchedTransformEnabled())
+        window,     ///< Hann window read from the input ring, decimated into the sub-transform inputs
+        transform,  ///< One quarter-size FFT per slice (complex, also carrying the reference, when enabled)
+        combine,    ///< First radix-2 butterfly pass (quarter -> half-size spectra)
+        spectrum,   ///< Final butterfly fused with magnitude and running argmax
+        suppress,   ///< Reference magnitudes subtracted, argmax of what remains (optional)
+        denoise,    ///< Noise floor learning and subtraction, argmax of peaks above the floor (optional)
+        separate,   ///< Harmonic/percussive median filtering and argmax of the harmonic part (optional)
+        chroma,     ///< Magnitudes folded into 12 pitch classes through the sparse chroma matrix
+        finish      ///< Peak refinement, note lookup and stability tracking
+    };
+
+    /**
+     * Writes input to the ring through the pre-filter, and the reference to its ring.
+     *
+     * @param data          Samples to write
+     * @param referenceData Reference samples to write alongside, or nullptr for silence
+     * @param numSamples    Number of samples (at most the ring's free space)
+     */
+    void writeInput(const float* data, const float* referenceData, int numSamples);
+
+    /** Starts analysing the oldest complete frame of pending input. */
+    void beginFrame();
+
+    /** Gets the stage that follows the spectrum stage for the enabled features. */
+    AnalysisStage getStageAfterSpectrum() const;
+
+    /**
+     * Runs slices of the in-flight frame for a block of incoming samples.
+     *
+     * @param numSamples Number of samples in the current block
+     */
+    void advanceAnalysis(int numSamples);
+
+    /**
+     * Performs the next slice of the in-flight frame.
+     *
+     * @return Cost of the slice in work units
+     */
+    float runAnalysisSlice();
+
+    /**
+     * Splits the spectrum of a packed sub-transform into its input and reference parts.
+     *
+     * @param spectrum  FFT of input + i * reference; left holding the input's spectrum
+     * @param reference Receives the reference's spectrum
+     */
+    static void splitPackedSpectrum(std::complex<float>* spectrum, std::complex<float>* reference);
+
+    /**
+     * Performs one slice of reference subtraction on fftMagnitudes_.
+     *
+     * @param begin First bin of the slice
+     * @param end   One past the last bin of the slice
+     */
+    void suppressReferenceSlice(int begin, int end);
+
+    /**
+     * Performs one slice of harmonic/percussive separation on fftMagnitudes_.
+     *
+     * @param begin First bin of the slice
+     * @param end   One past the last bin of the slice
+     */
+    void separateHarmonicSlice(int begin, int end);
+
+    /** Restarts every bin's time median from silence. */
+    void clearTimeMedians();
+
+    /**
+     * Performs one slice of noise floor learning and subtraction on fftMagnitudes_.
+     *
+     * @param begin First bin of the slice
+     * @param end   One past the last bin of the slice
+     */
+    void denoiseSlice(int begin, int end);
+
+    /** Forgets the learned noise floor. */
+    void clearNoiseProfile();
+
+    /** Runs all remaining slices of the in-flight frame. */
+    void completeFrame();
+
+    /** Checks if the peak search covers a bin. */
+    bool isSearchedBin(int bin) const { return bin >= lowestBin_ && bin <= highestBin_; }
+
+    /**
+     * Locates a peak to sub-bin accuracy by parabolic interpolation.
+     *
+     * @param bin Bin of the peak in fftMagnitudes_
+     * @return Fractional bin of the interpolated peak
+     */
+    float refinePeak(int bin) const;
+
+    /** Checks if a (fractional) bin lies within the frequency range set by setFrequencyRange(). */
+    bool isInSearchRange(float bin) const;
+
+    /** Picks the strongest local maximum strictly inside the search range (-1 magnitude if none). */
+    void findStrongestPeakInRange();
+
+    /** Refines the strongest peak and maps it to a candidate note. */
+    void finishFrame();
+
+    /** Publishes the strongest detected note as the latest FrameResult. */
+    void publishFrame(juce::int64 frameEndSample);
+
+    /** Copies detectedNotes_ to the snapshot getDetectedNotes() reads (audio thread, or prepare()/reset()). */
+    void publishDetectedNotes();
+
+    /** Points nothing into the arena, so a failed prepare() leaves no stale pointers behind. */
+    void detachWorkingMemory();
 
     /** Updates note stability tracking and builds stable detected notes list. */
     void updateNoteStability();
@@ -148,24 +555,150 @@ private:
     static constexpr int fftOrder_ = 12;                      ///< FFT order (4096 samples for better low-freq resolution)
     static constexpr int fftSize_ = 1 << fftOrder_;           ///< FFT size (4096)
     static constexpr int maxNotes_ = 1;                       ///< Monophonic detection (single note)
+    static constexpr int subFftSize_ = fftSize_ / 4;          ///< Size of each decimated sub-transform
+
+    // Shared Read-Only Tables (window, twiddles, note map)
+    std::shared_ptr<const SharedAnalysisTables> tables_;      ///< Shared with every instance of the same configuration
+    std::unique_ptr<juce::dsp::FFT> subFft_;                  ///< Quarter-size engine for the sub-transforms (own, since engines may keep work buffers)
+    WindowType windowType_ = WindowType::hann;                ///< Window used for the next prepare()
+    const float* windowBuffer_ = nullptr;                     ///< Window coefficients (owned by tables_)
+    const std::complex<float>* twiddles_ = nullptr;           ///< exp(-2πik / fftSize_) for k < fftSize_ / 2 (owned by tables_)
+
+    // Working Memory (every pointer below points into arena_, laid out in prepare())
+    DetectorArena arena_;                                     ///< Single aligned block for all buffers
+    bool lockMemory_ = false;                                 ///< Lock arena_ into physical memory
+    float* fftBuffer_ = nullptr;                              ///< Four sub-transform regions (fftSize_ / 2 floats each)
+    float* fftMagnitudes_ = nullptr;                          ///< Frequency-domain output (fftSize_ / 2 bins)
+
+    // Amortised Analysis (slice costs are relative work units)
+    static constexpr int windowSlices_ = 8;                   ///< Slices in the window stage
+    static constexpr int transformSlices_ = 4;                ///< One slice per sub-transform
+    static constexpr int combineSlices_ = 4;                  ///< Slices in the combine stage
+    static constexpr int spectrumSlices_ = 4;                 ///< Slices in the spectrum stage
+    static constexpr int suppressSlices_ = 2;                 ///< Slices in the suppress stage
+    static constexpr int denoiseSlices_ = 4;                  ///< Slices in the denoise stage
+    static constexpr int separateSlices_ = 2;                 ///< Slices in the separate stage
+    static constexpr int chromaSlices_ = 1;                   ///< Slices in the chroma stage
+    static constexpr float transformSliceCost_ = 4.0f;        ///< Quarter-size FFT vs. one window slice
+    static constexpr float spectrumSliceCost_ = 2.0f;         ///< Butterfly + sqrt vs. one window slice
+    static constexpr float baseSliceCost_ = windowSlices_ + transformSlices_ * transformSliceCost_
+                                          + combineSlices_ + spectrumSlices_ * spectrumSliceCost_ + chromaSlices_ + 1.0f;
+    float totalSliceCost_ = baseSliceCost_;                   ///< Work units per frame, including enabled stages
+    float streamCost_ = 1.0f;                                 ///< Scale of the per-stream stages (2 with the reference)
+
+    bool amortiseAnalysis_ = true;                            ///< Spread frame work across callbacks
+    bool batchTransform_ = false;                             ///< Leave each frame's transform to the caller
+    int analysisSpreadSamples_ = fftSize_ / 2;                ///< Samples over which a frame's work is spread
+    AnalysisStage analysisStage_ = AnalysisStage::idle;       ///< Stage of the in-flight frame
+    int stageSlice_ = 0;                                      ///< Next slice within the current stage
+    float sliceCredit_ = 0.0f;                                ///< Work budget carried between callbacks
+    const float* frameData_ = nullptr;                        ///< Contiguous input span of the in-flight frame
+    float searchLowestHz_ = 0.0f;                             ///< Peak search range for the next prepare()
+    float searchHighestHz_ = 0.0f;                            ///< (0 = up to Nyquist)
+    int lowestBin_ = 2;                                       ///< First bin the peak is searched in
+    int highestBin_ = fftSize_ / 2 - 1;                       ///< Last bin the peak is searched in
+    int strongestBin_ = 2;                                    ///< Running argmax of the in-flight frame
+    float strongestMagnitude_ = 0.0f;                         ///< Magnitude at strongestBin_
+    std::atomic<juce::int64> worstCallbackTicks_{ 0 };        ///< Longest processAudioBlock() call
+
+    // Input Ring
+    MirroredRingBuffer inputRing_;                            ///< Last 2 frames of input, always contiguous
+    PreFilter preFilter_;                                     ///< Rumble/hum removal ahead of the ring
+    PreFilter::Settings preFilterSettings_;                   ///< For the next prepare()
+    static constexpr int preFilterChunk_ = 256;               ///< Samples filtered per pass into preFilterBuffer_
+    float* preFilterBuffer_ = nullptr;                        ///< Filtered input on its way to the ring (preFilterChunk_)
+    int pendingSamples_ = 0;                                  ///< Samples written but not yet assigned to a frame
+    juce::int64 streamPosition_ = 0;                          ///< Samples received since prepare()
+    juce::int64 ringStreamPosition_ = 0;                      ///< Stream position just past the newest ring sample
+    juce::int64 frameEndSample_ = 0;                          ///< Stream position just past the in-flight frame
+    FrameResult latestFrame_;                                 ///< Published result (audio thread)
+    std::array<FrameResult, maxRecentFrames> recentFrames_;   ///< Last few results, by frameIndex % maxRecentFrames
+    float inputLevel_ = 0.0f;                                 ///< RMS of the last block (audio thread)
+    int sourceChannel_ = 0;                                   ///< Channel results are tagged with
 
-    // FFT Processing
-    std::unique_ptr<juce::dsp::FFT> fft_;                     ///< FFT processor
-    juce::HeapBlock<float> fftBuffer_;                        ///< Time-domain input buffer
-    juce::HeapBlock<float> fftMagnitudes_;                    ///< Frequency-domain output
-    juce::HeapBlock<float> windowBuffer_;                     ///< Hann window coefficients
+    // Accompaniment Reference (input and reference FFTs share one complex transform per region)
+    static constexpr float bleedGainRise_ = 0.1f;             ///< Per-frame approach of a higher bleed estimate
+    bool useReference_ = false;                               ///< Reference requested for the next prepare()
+    MirroredRingBuffer referenceRing_;                        ///< Reference samples, in step with inputRing_
+    const float* referenceFrameData_ = nullptr;               ///< Reference span of the in-flight frame
+    float* referenceBuffer_ = nullptr;                        ///< Packed transform inputs, then reference sub-spectra; null when disabled
+    float* referenceMagnitudes_ = nullptr;                    ///< Reference magnitudes (fftSize_ / 2 bins)
+    float referenceCorrelation_ = 0.0f;                       ///< Sum of input * reference magnitudes this frame
+    float referenceEnergy_ = 0.0f;                            ///< Sum of squared reference magnitudes this frame
+    float bleedGain_ = 0.0f;                                  ///< Estimated reference level in the input
+    float referenceSuppression_ = 2.0f;                       ///< Over-subtraction of the scaled reference
 
-    // FIFO Buffer
-    juce::AbstractFifo fifo_;                                 ///< Lock-free FIFO for samples
-    std::vector<float> fifoBuffer_;                           ///< FIFO storage
+    // Chroma
+    const SharedAnalysisTables::ChromaWeight* chromaWeights_ = nullptr; ///< Sparse matrix (owned by tables_)
+    int numChromaWeights_ = 0;                                ///< Entries in chromaWeights_
+    std::array<float, 12> frameChroma_ {};                    ///< Pitch-class magnitudes of the in-flight frame
+    std::array<float, 12> chroma_ {};                         ///< Decaying accumulation of frameChroma_
+    float chromaHalfLifeSeconds_ = 0.5f;                      ///< Accumulation half-life
+    float chromaDecay_ = 0.0f;                                ///< Per-frame decay for that half-life
+
+    // Harmonic/Percussive Separation
+    static constexpr int timeMedianFrames_ = 3;               ///< Frames in each bin's (causal) time median
+    static constexpr int frequencyMedianBins_ = 17;           ///< Bins in the frequency median, centred on the bin
+    using TimeMedian = SlidingMedian<timeMedianFrames_>;
+    using FrequencyMedian = SlidingMedian<frequencyMedianBins_>;
+    bool separateHarmonics_ = false;                          ///< Separation requested for the next prepare()
+    int separationBins_ = 0;                                  ///< Bins separated (up to C8); 0 when disabled
+    TimeMedian* timeMedians_ = nullptr;                       ///< One per separated bin (separationBins_)
+    FrequencyMedian frequencyMedian_;                         ///< Slides along the bins of the in-flight frame
+    juce::int64 separationTicks_ = 0;                         ///< Separation time of the in-flight frame
+    std::atomic<juce::int64> worstSeparationTicks_{ 0 };      ///< Longest separation of one frame
+
+    // Noise Profile (minimum statistics: the floor is the smallest smoothed magnitude seen
+    // over noiseSubwindows_ subwindows of learned frames, scaled up by the bias of that minimum)
+    static constexpr int noiseSubwindows_ = 4;                ///< Subwindows the minimum is tracked over
+    static constexpr float noiseSubwindowSeconds_ = 0.4f;     ///< Learned audio per subwindow
+    static constexpr float noiseSmoothing_ = 0.7f;            ///< Per-frame smoothing of magnitudes before the minimum
+    static constexpr float noiseBiasCompensation_ = 1.5f;     ///< Mean noise magnitude / its smoothed minimum
+    struct NoiseBin
+    {
+        float smoothed = 0.0f;                                ///< Smoothed magnitude over learned frames
+        float subwindowMinimum = 0.0f;                        ///< Minimum of smoothed in the current subwindow
+        float windowMinimum = 0.0f;                           ///< Minimum over the completed subwindows
+        std::array<float, noiseSubwindows_> minima {};        ///< Completed subwindow minima, oldest overwritten
+
+        /** Gets the learned noise magnitude (only meaningful once the profile is learned). */
+        float getFloor() const { return noiseBiasCompensation_ * juce::jmin(windowMinimum, subwindowMinimum); }
+    };
+    bool useNoiseProfile_ = false;                            ///< Noise profile requested for the next prepare()
+    NoiseBin* noiseBins_ = nullptr;                           ///< One per bin (fftSize_ / 2); null when disabled
+    int noiseSubwindowFrames_ = 1;                            ///< Learned frames per subwindow at this sample rate
+    int noiseWindowFrames_ = noiseSubwindows_;                ///< Learned frames before the floor is trusted
+    int noiseFramesLearned_ = 0;                              ///< Frames the floor has learned from
+    bool learnNoise_ = false;                                 ///< The in-flight frame updates the floor
+    bool subtractNoise_ = false;                              ///< The in-flight frame is measured against the floor
+    float noiseFloorRatio_ = 4.0f;                            ///< Peak / floor needed for detection
 
     // Audio State
     double sampleRate_ = 44100.0;                             ///< Current sample rate
     int expectedBlockSize_ = 512;                             ///< Expected block size
 
     // Detection Results
-    std::vector<DetectedNote> detectedNotes_;                 ///< Currently detected notes
-    std::vector<DetectedNote> candidateNotes_;                ///< Candidate notes from latest frame
+    struct NoteCandidate {
+        int midiNoteNumber = -1;
+        float frequency = 0.0f;
+        float magnitude = 0.0f;
+    };
+    NoteCandidate* detectedNotes_ = nullptr;                  ///< Currently detected notes (maxNotes_)
+    int numDetectedNotes_ = 0;
+    NoteCandidate* candidateNotes_ = nullptr;                 ///< Candidate notes from latest frame (maxNotes_)
+    int numCandidateNotes_ = 0;
+
+    // Detected notes as published for other threads: a sequence lock over relaxed atomics,
+    // kept outside arena_ so releasing the arena never leaves a reader looking at freed memory
+    struct PublishedNote {
+        std::atomic<int> midiNoteNumber { -1 };
+        std::atomic<float> frequency { 0.0f };
+        std::atomic<float> magnitude { 0.0f };
+    };
+    std::array<PublishedNote, maxNotes_> publishedNotes_;    ///< Copy of detectedNotes_
+    std::atomic<int> numPublishedNotes_ { 0 };                ///< Valid entries in publishedNotes_
+    std::atomic<int> publishedChannel_ { 0 };                 ///< Source channel the notes were detected on
+    std::atomic<juce::uint32> publishedSequence_ { 0 };       ///< Odd while the copy is being written
 
     // Note Stability Tracking
     struct NoteHistory {
@@ -173,7 +706,8 @@ private:
         int consecutiveFrames = 0;
         float totalMagnitude = 0.0f;
     };
-    std::vector<NoteHistory> noteHistory_;                    ///< Track note stability
+    NoteHistory* noteHistory_ = nullptr;                      ///< Track note stability (maxNotes_ * 2)
+    int numHistoryEntries_ = 0;
     static constexpr int stabilityFramesRequired_ = 2;        ///< Frames needed to confirm note (reduced for faster response)
 
     // Thresholds
@@ -183,25 +717,10 @@ private:
     // Status
     std::atomic<bool> isActive_{ false };                     ///< Audio activity flag
 
-    // Note Names
-    const std::array<juce::String, 12> noteNames_ = {
-        "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"
-    };
-
-    // Frequency-to-Note Mapping
-    std::vector<NoteFrequencyRange> frequencyMap_;
-
-    //==============================================================================
-    /** Initializes the frequency-to-note mapping table. */
-    void initializeFrequencyMap();
-
-    /**
-     * Finds which note a frequency belongs to.
-     *
-     * @param frequency Frequency in Hz
-     * @return Pointer to NoteFrequencyRange or nullptr if out of range
-     */
-    const NoteFrequencyRange* findNoteForFrequency(float frequency) const;
+    // Startup Timing
+    const juce::int64 constructionTicks_ = juce::Time::getHighResolutionTicks();  ///< When this instance was created
+    std::atomic<juce::int64> prepareTicks_{ 0 };              ///< Duration of the last prepare()
+    std::atomic<juce::int64> firstResultTicks_{ 0 };          ///< Construction to first finished frame (0 until then)
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PitchDetector)
 };
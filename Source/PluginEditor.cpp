@@ -25,6 +25,12 @@ MonolithMaestroEditor::MonolithMaestroEditor(MonolithMaestroProcessor& p)
     copyButton_.onClick = [this] { copyButtonClicked(); };
     addAndMakeVisible(copyButton_);
 
+    // Setup export button
+    exportButton_.setButtonText("Export MIDI");
+    exportButton_.onClick = [this] { exportButtonClicked(); };
+    exportButton_.setEnabled(false);
+    addAndMakeVisible(exportButton_);
+
     startTimer(50);  // Update display at 20Hz
     setSize(500, 800);
 }
@@ -56,6 +62,24 @@ void MonolithMaestroEditor::paint(juce::Graphics& g)
     g.setColour(juce::Colour(0xff888888));
     g.drawText("Real-Time Pitch Detection", 0, 60, getWidth(), 20, juce::Justification::centred);
 
+    // Live key estimate and chord
+    juce::String harmonyText;
+
+    if (liveKey_.isValid())
+        harmonyText << "Key: " << liveKey_.getName();
+
+    if (liveChord_.isValid())
+        harmonyText << (harmonyText.isEmpty() ? "" : "    ") << "Chord: " << liveChord_.getName();
+
+    if (trackedTempo_ > 0.0)
+        harmonyText << (harmonyText.isEmpty() ? "" : "    ") << juce::roundToInt(trackedTempo_) << " BPM";
+
+    if (harmonyText.isNotEmpty())
+    {
+        g.setColour(juce::Colour(0xffaaaaaa));
+        g.drawText(harmonyText, 0, 80, getWidth(), 20, juce::Justification::centred);
+    }
+
     // Detected notes or idle message
     if (currentNotes_.empty())
     {
@@ -128,10 +152,11 @@ void MonolithMaestroEditor::resized()
     auto recordButtonArea = bounds.removeFromTop(80);
     recordButton_.setBounds(recordButtonArea.reduced(150, 20));
 
-    // Bottom section: recorded notes display + copy button
+    // Bottom section: recorded notes display + copy/export buttons
     auto bottomArea = bounds;
-    auto copyButtonArea = bottomArea.removeFromBottom(50);
-    copyButton_.setBounds(copyButtonArea.reduced(180, 10));
+    auto buttonArea = bottomArea.removeFromBottom(50).reduced(100, 10);
+    copyButton_.setBounds(buttonArea.removeFromLeft(buttonArea.getWidth() / 2).reduced(5, 0));
+    exportButton_.setBounds(buttonArea.reduced(5, 0));
 
     recordedNotesDisplay_.setBounds(bottomArea.reduced(20, 10));
 }
@@ -139,6 +164,9 @@ void MonolithMaestroEditor::resized()
 void MonolithMaestroEditor::timerCallback()
 {
     currentNotes_ = processorRef.getDetectedNotes();
+    liveKey_ = processorRef.getLiveKey();
+    liveChord_ = processorRef.getDetectedChord();
+    trackedTempo_ = processorRef.getTrackedTempo();
     repaint();
 }
 
@@ -151,15 +179,34 @@ void MonolithMaestroEditor::recordButtonClicked()
         recordButton_.setButtonText("Stop");
         recordButton_.setColour(juce::TextButton::buttonColourId, juce::Colours::red);
         recordedNotesDisplay_.clear();
+        exportButton_.setEnabled(false);
     }
     else
     {
-        // Stop recording
-        auto notes = processorRef.stopRecording();
-        auto key = processorRef.getDetectedKey();
+        // Stop recording; the take is finished in the background and shown once its keys are analysed
+        juce::Component::SafePointer<MonolithMaestroEditor> editor(this);
+
+        processorRef.stopRecording([editor](RecordingHandle recording)
+        {
+            if (editor == nullptr)
+                return;
+
+            editor->lastRecording_ = recording;
+            editor->recordButton_.setEnabled(true);
+            editor->exportButton_.setEnabled(recording->getMidiFile().existsAsFile());
+            editor->recordedNotesDisplay_.setText("Analysing recording...", false);
+        },
+        [editor](RecordingHandle analysed)
+        {
+            if (editor != nullptr && editor->lastRecording_ == analysed)
+                editor->updateRecordedNotesDisplay(*analysed);
+        });
+
+        // A new take waits until this one is finished
         recordButton_.setButtonText("Record");
         recordButton_.setColour(juce::TextButton::buttonColourId, juce::Colours::grey);
-        updateRecordedNotesDisplay(notes, key);
+        recordButton_.setEnabled(false);
+        recordedNotesDisplay_.setText("Finishing recording...", false);
     }
 }
 
@@ -181,25 +228,128 @@ void MonolithMaestroEditor::copyButtonClicked()
     }
 }
 
-void MonolithMaestroEditor::updateRecordedNotesDisplay(const std::vector<juce::String>& notes, const juce::String& key)
+void MonolithMaestroEditor::exportButtonClicked()
+{
+    if (lastRecording_ == nullptr || !lastRecording_->getMidiFile().existsAsFile())
+        return;
+
+    fileChooser_ = std::make_unique<juce::FileChooser>("Export MIDI File",
+                                                       juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+                                                           .getChildFile("Recording.mid"),
+                                                       "*.mid");
+
+    const auto flags = juce::FileBrowserComponent::saveMode
+                       | juce::FileBrowserComponent::canSelectFiles
+                       | juce::FileBrowserComponent::warnAboutOverwriting;
+
+    fileChooser_->launchAsync(flags, [this, recording = lastRecording_](const juce::FileChooser& chooser)
+    {
+        const auto destination = chooser.getResult();
+        if (destination == juce::File())
+            return;
+
+        // The file was streamed while recording; exporting is just a copy, kept off the message thread
+        juce::Component::SafePointer<MonolithMaestroEditor> editor(this);
+
+        juce::Thread::launch([recording, destination, editor]
+        {
+            const bool ok = recording->getMidiFile().copyFileTo(destination.withFileExtension(".mid"));
+
+            juce::MessageManager::callAsync([editor, ok]
+            {
+                if (editor != nullptr)
+                    editor->exportButton_.setButtonText(ok ? "Exported!" : "Export failed");
+
+                juce::Timer::callAfterDelay(1000, [editor]
+                {
+                    if (editor != nullptr)
+                        editor->exportButton_.setButtonText("Export MIDI");
+                });
+            });
+        });
+    });
+}
+
+void MonolithMaestroEditor::updateRecordedNotesDisplay(const RecordingStore& recording)
 {
+    // A summary rather than the whole take: an hours-long recording would mean reading
+    // its spill file back on the message thread and building a text of every note
+    const auto numNotes = recording.getNumEvents();
     juce::String displayText;
 
-    if (notes.empty())
+    if (numNotes == 0)
     {
         displayText = "No notes recorded.\n\nPlay some notes and press Record to capture them!";
     }
     else
     {
-        displayText << "Recorded Notes:\n";
-        for (size_t i = 0; i < notes.size(); ++i)
+        juce::String noteList;
+        int numListed = 0;
+
+        recording.forEachRecentEvent(maxNotesShown_, [&](const NoteEvent& event)
         {
-            displayText << notes[i];
-            if (i < notes.size() - 1)
-                displayText << " → ";
+            if (noteList.isNotEmpty())
+                noteList << " → ";
+
+            noteList << CompileTimeTables::noteNames[(size_t) (event.midiNoteNumber % 12)];
+            ++numListed;
+        });
+
+        displayText << "Recorded Notes: " << juce::String(numNotes);
+
+        if (numListed < numNotes)
+            displayText << " (last " << numListed << " shown)";
+
+        displayText << "\n" << noteList;
+
+        const KeyEstimator::Estimate key { recording.getKey(), recording.getKeyConfidence() };
+        displayText << "\n\nDetected Key: " << (key.isValid() ? key.getName() : juce::String("Unknown"));
+
+        // Sections in different keys, by bar when the host timeline was running
+        const auto& regions = recording.getKeyRegions();
+        if (regions.size() > 1)
+        {
+            displayText << "\n\nKey Changes: " << ((int) regions.size() - 1);
+
+            for (size_t i = 0; i < juce::jmin(regions.size(), (size_t) maxChangesShown_); ++i)
+                displayText << "\n" << formatRecordingPosition(regions[i].hasHostTime, regions[i].startBar, regions[i].startSample)
+                            << "  " << KeyEstimator::Estimate { regions[i].key, regions[i].confidence }.getName();
+
+            if (regions.size() > (size_t) maxChangesShown_)
+                displayText << "\n...";
         }
-        displayText << "\n\nDetected Key: " << key;
+    }
+
+    // Chord chart, one line per change
+    const auto& chords = recording.getChords();
+    if (!chords.empty())
+    {
+        displayText << "\n\nChords: " << (int) chords.size() << " changes";
+
+        for (size_t i = 0; i < juce::jmin(chords.size(), (size_t) maxChangesShown_); ++i)
+        {
+            const auto& chord = chords[i];
+            const DetectedChord detected { chord.root, chord.quality, chord.confidence };
+            displayText << "\n" << formatRecordingPosition(chord.hasHostTime, chord.bar, chord.onsetSample)
+                        << "  " << (detected.isValid() ? detected.getName() : juce::String("N.C."));
+        }
+
+        if (chords.size() > (size_t) maxChangesShown_)
+            displayText << "\n...";
+
+        if (recording.getNumDroppedChords() > 0)
+            displayText << "\n(" << recording.getNumDroppedChords() << " later changes not kept)";
     }
 
     recordedNotesDisplay_.setText(displayText, false);
 }
+
+juce::String MonolithMaestroEditor::formatRecordingPosition(bool hasHostTime, int bar, juce::int64 sample) const
+{
+    if (hasHostTime)
+        return "Bar " + juce::String(bar + 1);
+
+    const double sampleRate = processorRef.getSampleRate() > 0.0 ? processorRef.getSampleRate() : 44100.0;
+    const auto seconds = (int) ((double) sample / sampleRate);
+    return juce::String(seconds / 60) + ":" + juce::String(seconds % 60).paddedLeft('0', 2);
+}
@@ -30,16 +30,30 @@ private:
     /** Handles copy button click. */
     void copyButtonClicked();
 
-    /** Updates the recorded notes display text. */
-    void updateRecordedNotesDisplay(const std::vector<juce::String>& notes, const juce::String& key);
+    /** Handles export button click: saves the last recording as a MIDI file. */
+    void exportButtonClicked();
+
+    /** Updates the recorded notes display with a bounded summary of an analysed recording. */
+    void updateRecordedNotesDisplay(const RecordingStore& recording);
+
+    /** Formats a position in a recording: the bar if it has host time, else m:ss. */
+    juce::String formatRecordingPosition(bool hasHostTime, int bar, juce::int64 sample) const;
 
     MonolithMaestroProcessor& processorRef;            ///< Reference to processor
     std::vector<DetectedNote> currentNotes_;           ///< Currently detected notes
+    KeyEstimator::Estimate liveKey_;                   ///< Key of the notes played recently
+    DetectedChord liveChord_;                          ///< Chord currently sounding
+    double trackedTempo_ = 0.0;                        ///< Tempo followed from the input (0 = not locked)
 
     // Recording UI components
     juce::TextButton recordButton_;                    ///< Record/Stop button
     juce::TextEditor recordedNotesDisplay_;            ///< Display area for recorded notes
     juce::TextButton copyButton_;                      ///< Copy to clipboard button
+    juce::TextButton exportButton_;                    ///< Export MIDI file button
+    std::unique_ptr<juce::FileChooser> fileChooser_;   ///< Export destination dialog
+    RecordingHandle lastRecording_;                    ///< Recording shown in the display
+    static constexpr int maxNotesShown_ = 64;          ///< Latest notes listed in the summary
+    static constexpr int maxChangesShown_ = 32;        ///< Key regions and chord changes listed in the summary
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MonolithMaestroEditor)
 };
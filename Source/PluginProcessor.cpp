@@ -6,12 +6,15 @@
 MonolithMaestroProcessor::MonolithMaestroProcessor()
     : AudioProcessor(BusesProperties()
                          .withInput("Input", juce::AudioChannelSet::stereo(), true)
+                         .withInput("Sidechain", juce::AudioChannelSet::stereo(), false)
                          .withOutput("Output", juce::AudioChannelSet::stereo(), true))
 {
 }
 
 MonolithMaestroProcessor::~MonolithMaestroProcessor()
 {
+    // Queued key analyses are dropped; a running one finishes but delivers nothing
+    analysisPool_.removeAllJobs(true, 10000);
 }
 
 //==============================================================================
@@ -27,7 +30,7 @@ bool MonolithMaestroProcessor::acceptsMidi() const
 
 bool MonolithMaestroProcessor::producesMidi() const
 {
-    return false;
+    return true;
 }
 
 bool MonolithMaestroProcessor::isMidiEffect() const
@@ -69,15 +72,127 @@ void MonolithMaestroProcessor::changeProgramName(int index, const juce::String&
 //==============================================================================
 void MonolithMaestroProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
+    // Analyse the accompaniment only when the host routes one to the sidechain
+    const auto* sidechain = getBus(true, 1);
+    const bool hasReference = sidechain != nullptr && sidechain->isEnabled();
+
+    forEachDetector([hasReference](PitchDetector& detector)
+    {
+        // Keep analysis buffers resident so the first frame never page-faults (best-effort)
+        detector.setMemoryLockingEnabled(true);
+        detector.setReferenceInputEnabled(hasReference);
+    });
+
+    // More than two inputs is a divided pickup: the channel strategy doesn't apply
+    const int numStrings = getMainBusNumInputChannels() > 2 ? getMainBusNumInputChannels() : 0;
+    const bool isStereo = getMainBusNumInputChannels() == 2;
+    channelStrategy_ = requestedChannelStrategy_.load(std::memory_order_relaxed);
+    analyseSecondChannel_ = isStereo && channelStrategy_ == ChannelStrategy::independent;
+    analysisBuffer_.setSize(1, juce::jmax(1, samplesPerBlock));
+    channelLevels_.fill(0.0f);
+    loudestChannel_ = 0;
+
+    // Results are tagged with the channel they come from (-1 for a mix of channels)
+    const bool analysesMix = numStrings > 0
+                             || (isStereo && (channelStrategy_ == ChannelStrategy::mid || channelStrategy_ == ChannelStrategy::side));
     pitchDetector_.prepare(sampleRate, samplesPerBlock);
+    pitchDetector_.setSourceChannel(analysesMix ? -1 : isStereo && channelStrategy_ == ChannelStrategy::right ? 1 : 0);
+
+    if (analyseSecondChannel_)
+    {
+        secondChannelDetector_.prepare(sampleRate, samplesPerBlock);
+        secondChannelDetector_.setSourceChannel(1);
+        detectorWorker_.start(sampleRate, samplesPerBlock);
+    }
+    else
+    {
+        detectorWorker_.stop();
+    }
+
+    stringDetectors_.prepare(sampleRate, samplesPerBlock, numStrings);
 
     // Configure thresholds for accurate pitch detection
-    pitchDetector_.setNoiseGateThreshold(0.001f);
-    pitchDetector_.setMagnitudeThreshold(0.02f);
+    forEachDetector([](PitchDetector& detector)
+    {
+        detector.setNoiseGateThreshold(0.001f);
+        detector.setMagnitudeThreshold(0.02f);
+    });
+
+    // Each string, or channel analysed independently, gets its own note track and MIDI channel
+    if (numStrings > 0)
+    {
+        numNoteSources_ = numStrings;
+
+        for (int string = 0; string < numStrings; ++string)
+            noteSources_[static_cast<size_t>(string)].detector = &stringDetectors_.getStringDetector(string);
+    }
+    else
+    {
+        numNoteSources_ = analyseSecondChannel_ ? 2 : 1;
+        noteSources_[0].detector = &pitchDetector_;
+        noteSources_[1].detector = &secondChannelDetector_;
+    }
+
+    keyEstimator_.prepare(sampleRate);
+    chordRecognizer_.reset();
+    lastChromaFrameIndex_ = 0;
+
+    // Results are published up to one analysis spread after their frame ends. While MIDI is output,
+    // report that as latency so messages can be placed at the frame end, and delay the audio to match
+    analysisSpreadSamples_ = pitchDetector_.getAnalysisSpreadSamples();
+    const int latencySamples = isMidiOutputEnabled() ? analysisSpreadSamples_ : 0;
+    latencySamples_.store(latencySamples, std::memory_order_relaxed);
+    setLatencySamples(latencySamples);
+    hostTimeline_.prepare(sampleRate, latencySamples);
+
+    for (int i = 0; i < numNoteSources_; ++i)
+    {
+        auto& source = noteSources_[static_cast<size_t>(i)];
+        source.sourceChannel = (juce::int8) (numNoteSources_ > 1 ? i : -1);
+        source.segmenter.prepare(sampleRate, source.detector->getDetectionLatencySamples());
+        source.segmenter.setLevelFloor(0.001f);
+        source.midiOutput.prepare(sampleRate, latencySamples);
+        source.midiOutput.setChannelSlot(i, numNoteSources_);
+        source.lastFrameIndex = 0;
+        source.openNoteOnset = {};
+    }
+
+    beatTracker_.prepare(sampleRate);
+
+    // Room for the full spread, so output can be switched on without another prepareToPlay()
+    passThroughDelay_.setMaximumDelayInSamples(juce::jmax(1, analysisSpreadSamples_));
+    passThroughDelay_.prepare({ sampleRate, (juce::uint32) samplesPerBlock,
+                                (juce::uint32) juce::jmax(1, getTotalNumOutputChannels()) });
+    applyLatency(latencySamples);
+}
+
+void MonolithMaestroProcessor::setMidiOutputEnabled(bool shouldBeEnabled)
+{
+    for (auto& source : noteSources_)
+        source.midiOutput.setEnabled(shouldBeEnabled);
+
+    const int latencySamples = shouldBeEnabled ? analysisSpreadSamples_ : 0;
+    if (latencySamples_.exchange(latencySamples, std::memory_order_relaxed) != latencySamples)
+        setLatencySamples(latencySamples);
+}
+
+void MonolithMaestroProcessor::applyLatency(int latencySamples)
+{
+    for (auto& source : noteSources_)
+        source.midiOutput.setLatencySamples(latencySamples);
+
+    hostTimeline_.setLatencySamples(latencySamples);
+    passThroughDelay_.reset();
+    passThroughDelay_.setDelay((float) latencySamples);
+    appliedLatencySamples_ = latencySamples;
 }
 
 void MonolithMaestroProcessor::releaseResources()
 {
+    for (auto& source : noteSources_)
+        source.midiOutput.reset();
+
+    detectorWorker_.stop();
 }
 
 bool MonolithMaestroProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
@@ -86,60 +201,91 @@ bool MonolithMaestroProcessor::isBusesLayoutSupported(const BusesLayout& layouts
         && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
         return false;
 
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+    // A divided pickup brings one input per string, passed through as their sum
+    const int numInputChannels = layouts.getMainInputChannelSet().size();
+    const bool isStringInput = numInputChannels >= StringDetectorBank::minStrings
+                               && numInputChannels <= StringDetectorBank::maxStrings;
+
+    if (!isStringInput && layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
 
+    // The accompaniment sidechain is optional; only its first channel is analysed
+    if (layouts.inputBuses.size() > 1)
+    {
+        const auto sidechain = layouts.getChannelSet(true, 1);
+
+        if (!sidechain.isDisabled()
+            && sidechain != juce::AudioChannelSet::mono()
+            && sidechain != juce::AudioChannelSet::stereo())
+            return false;
+    }
+
     return true;
 }
 
 void MonolithMaestroProcessor::processBlock(juce::AudioBuffer<float>& buffer,
                                           juce::MidiBuffer& midiMessages)
 {
-    juce::ignoreUnused(midiMessages);
-
     juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels = getTotalNumInputChannels();
+    auto totalNumInputChannels = getMainBusNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
     // Clear unused output channels
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
 
-    // Feed first channel to pitch detector
+    // MIDI output was switched on or off: the host now compensates a different latency
+    const int latencySamples = latencySamples_.load(std::memory_order_relaxed);
+    if (latencySamples != appliedLatencySamples_)
+        applyLatency(latencySamples);
+
+    // Feed the input to the pitch detector(s) as the channel strategy says
     if (totalNumInputChannels > 0)
     {
-        const float* channelData = buffer.getReadPointer(0);
         int numSamples = buffer.getNumSamples();
+        const auto blockStartSample = pitchDetector_.getStreamPosition();
+
+        // Accompaniment to subtract from the input, if the sidechain is connected
+        const float* referenceData = nullptr;
+        if (pitchDetector_.isReferenceInputActive() && getChannelCountOfBus(true, 1) > 0)
+            referenceData = getBusBuffer(buffer, true, 1).getReadPointer(0);
 
-        pitchDetector_.processAudioBlock(channelData, numSamples);
+        hostTimeline_.update(getPlayHead(), blockStartSample);
+        analyseInput(buffer, referenceData, midiMessages);
         audioActive.store(pitchDetector_.isActive());
 
-        // Capture notes during recording
-        if (isRecording_.load())
+        // A divided pickup is monitored like a normal one: all strings summed
+        if (stringDetectors_.getNumStrings() > 0)
         {
-            auto detectedNotes = pitchDetector_.getDetectedNotes();
-            if (!detectedNotes.empty())
-            {
-                // Get the strongest note (first in sorted vector)
-                const auto& strongestNote = detectedNotes[0];
-                const auto& noteName = strongestNote.noteName;
-
-                // Only record if different from last note (avoid duplicates)
-                if (noteName != lastRecordedNote_)
-                {
-                    const juce::ScopedLock lock(recordingLock_);
-                    recordedNotes_.push_back(noteName);
-                    lastRecordedNote_ = noteName;
-                }
-            }
+            auto* sum = buffer.getWritePointer(0);
+
+            for (int string = 1; string < stringDetectors_.getNumStrings(); ++string)
+                juce::FloatVectorOperations::add(sum, buffer.getReadPointer(string), numSamples);
+
+            for (int channel = 1; channel < totalNumOutputChannels; ++channel)
+                juce::FloatVectorOperations::copy(buffer.getWritePointer(channel), sum, numSamples);
         }
+
     }
     else
     {
         audioActive.store(false);
     }
 
-    // Pass-through audio (no processing)
+    // Pass-through audio, delayed by the reported latency (none while MIDI output is off)
+    if (appliedLatencySamples_ > 0)
+    {
+        for (int channel = 0; channel < totalNumOutputChannels; ++channel)
+        {
+            auto* channelData = buffer.getWritePointer(channel);
+
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                passThroughDelay_.pushSample(channel, channelData[i]);
+                channelData[i] = passThroughDelay_.popSample(channel);
+            }
+        }
+    }
 }
 
 //==============================================================================
@@ -167,176 +313,347 @@ void MonolithMaestroProcessor::setStateInformation(const void* data, int sizeInB
 //==============================================================================
 std::vector<DetectedNote> MonolithMaestroProcessor::getDetectedNotes() const
 {
-    return pitchDetector_.getDetectedNotes();
+    if (stringDetectors_.getNumStrings() > 0)
+        return stringDetectors_.getDetectedNotes();
+
+    auto notes = pitchDetector_.getDetectedNotes();
+
+    if (analyseSecondChannel_)
+    {
+        const auto secondChannelNotes = secondChannelDetector_.getDetectedNotes();
+        notes.insert(notes.end(), secondChannelNotes.begin(), secondChannelNotes.end());
+        std::sort(notes.begin(), notes.end());
+    }
+
+    return notes;
 }
 
 //==============================================================================
-// Recording Implementation
-
-void MonolithMaestroProcessor::startRecording()
+void MonolithMaestroProcessor::analyseInput(const juce::AudioBuffer<float>& buffer, const float* referenceData,
+                                            juce::MidiBuffer& midiMessages)
 {
-    const juce::ScopedLock lock(recordingLock_);
-    recordedNotes_.clear();
-    lastRecordedNote_.clear();
-    detectedKey_.clear();
-    isRecording_.store(true);
+    const int numSamples = buffer.getNumSamples();
+    const auto blockStartSample = pitchDetector_.getStreamPosition();
+    const bool isStereo = getMainBusNumInputChannels() == 2;
+    const int numStrings = stringDetectors_.getNumStrings();
+    const float* left = buffer.getReadPointer(0);
+    const float* right = isStereo ? buffer.getReadPointer(1) : left;
+
+    if (analyseSecondChannel_)
+    {
+        // The second channel's analysis runs on the worker while this thread does the first's
+        detectorWorker_.beginBlock(secondChannelDetector_, right, numSamples, referenceData);
+        beatTracker_.processBlock(left, numSamples, pitchDetector_.getStreamPosition());
+        pitchDetector_.processAudioBlock(left, numSamples, referenceData);
+        detectorWorker_.finishBlock();
+        consumeNewFrames(blockStartSample, numSamples, midiMessages);
+        return;
+    }
+
+    // Mixes are built in analysisBuffer_, so blocks larger than announced go through in pieces
+    const int chunkSize = analysisBuffer_.getNumSamples();
+
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        const int length = juce::jmin(chunkSize, numSamples - start);
+        const float* input = left + start;
+
+        if (numStrings > 0)
+        {
+            // Each string to its own detector, their sum to the main one
+            std::array<const float*, StringDetectorBank::maxStrings> strings {};
+            auto* sum = analysisBuffer_.getWritePointer(0);
+
+            for (int string = 0; string < numStrings; ++string)
+                strings[static_cast<size_t>(string)] = buffer.getReadPointer(string) + start;
+
+            juce::FloatVectorOperations::copy(sum, strings[0], length);
+
+            for (int string = 1; string < numStrings; ++string)
+                juce::FloatVectorOperations::add(sum, strings[static_cast<size_t>(string)], length);
+
+            stringDetectors_.processBlock(strings.data(), length, referenceData != nullptr ? referenceData + start : nullptr);
+            input = sum;
+        }
+        else if (isStereo)
+        {
+            auto* mix = analysisBuffer_.getWritePointer(0);
+
+            switch (channelStrategy_)
+            {
+                case ChannelStrategy::right:
+                    input = right + start;
+                    break;
+
+                case ChannelStrategy::mid:
+                    juce::FloatVectorOperations::add(mix, left + start, right + start, length);
+                    juce::FloatVectorOperations::multiply(mix, 0.5f, length);
+                    input = mix;
+                    break;
+
+                case ChannelStrategy::side:
+                    juce::FloatVectorOperations::subtract(mix, left + start, right + start, length);
+                    juce::FloatVectorOperations::multiply(mix, 0.5f, length);
+                    input = mix;
+                    break;
+
+                case ChannelStrategy::loudest:
+                    input = (selectLoudestChannel(buffer, start, length) == 0 ? left : right) + start;
+                    pitchDetector_.setSourceChannel(loudestChannel_);
+                    break;
+
+                case ChannelStrategy::left:
+                case ChannelStrategy::independent:
+                default:
+                    break;
+            }
+        }
+
+        beatTracker_.processBlock(input, length, pitchDetector_.getStreamPosition());
+        pitchDetector_.processAudioBlock(input, length, referenceData != nullptr ? referenceData + start : nullptr);
+        consumeNewFrames(blockStartSample, numSamples, midiMessages);
+    }
 }
 
-std::vector<juce::String> MonolithMaestroProcessor::stopRecording()
+void MonolithMaestroProcessor::consumeNewFrames(juce::int64 blockStartSample, int numSamples, juce::MidiBuffer& midiMessages)
 {
-    isRecording_.store(false);
+    const bool isRecording = isRecording_.load();
+    if (isRecording)
+        updateRecordingSession();
+
+    const auto keySource = liveKeySource_.load(std::memory_order_relaxed);
+    if (keySource != keyEstimatorSource_)
+    {
+        keyEstimator_.reset();
+        keyEstimatorSource_ = keySource;
+    }
 
-    const juce::ScopedLock lock(recordingLock_);
+    // Chords and the spectrum key follow the main detector, once per new frame
+    const auto latestChroma = pitchDetector_.getLatestFrame().frameIndex;
+    const auto numNewChroma = (juce::int32) (latestChroma - lastChromaFrameIndex_);
 
-    // Analyze key if we have notes
-    if (!recordedNotes_.empty())
+    for (int age = juce::jlimit(0, PitchDetector::maxRecentFrames, numNewChroma); --age >= 0;)
     {
-        analyzeKey();
+        const auto& frame = pitchDetector_.getFrame(latestChroma - (juce::uint32) age);
+
+        if (keySource == LiveKeySource::spectrum)
+            keyEstimator_.addChroma(frame.frameChroma, frame.frameEndSample);
+
+        // Chords are read from the smoothed chroma so passing tones don't register
+        if (chordRecognizer_.process(frame.chroma) && isRecording)
+            recordChord(chordRecognizer_.getCurrentChord(), frame.frameEndSample);
     }
-    else
+
+    lastChromaFrameIndex_ = latestChroma;
+
+    for (int i = 0; i < numNoteSources_; ++i)
     {
-        detectedKey_ = "No notes recorded";
+        auto& source = noteSources_[static_cast<size_t>(i)];
+        const auto& detector = *source.detector;
+
+        // One call can publish several frames when blocks are long; each is passed on in order.
+        // With none new the latest is passed again, so due MIDI is still written and levels still tracked
+        const auto latest = detector.getLatestFrame().frameIndex;
+        const auto numNew = (juce::int32) (latest - source.lastFrameIndex);
+        auto next = latest - (juce::uint32) juce::jlimit(0, PitchDetector::maxRecentFrames - 1, numNew - 1);
+
+        do
+        {
+            const auto& frame = detector.getFrame(next);
+            source.midiOutput.processBlock(frame, detector.getInputLevel(), blockStartSample, numSamples, midiMessages);
+
+            // Segment notes for the live key estimate (and the recording, if one is running)
+            captureNoteEvents(source, frame, isRecording);
+        }
+        while (next++ != latest);
+
+        source.lastFrameIndex = latest;
     }
+}
+
+int MonolithMaestroProcessor::selectLoudestChannel(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        auto& level = channelLevels_[static_cast<size_t>(channel)];
+        level += channelLevelSmoothing_ * (buffer.getRMSLevel(channel, startSample, numSamples) - level);
+    }
+
+    // Near-equal channels shouldn't trade places every block
+    const int other = 1 - loudestChannel_;
+    if (channelLevels_[static_cast<size_t>(other)] > channelSwitchRatio_ * channelLevels_[static_cast<size_t>(loudestChannel_)])
+        loudestChannel_ = other;
 
-    return recordedNotes_;
+    return loudestChannel_;
 }
 
-void MonolithMaestroProcessor::analyzeKey()
+//==============================================================================
+// Recording Implementation
+
+void MonolithMaestroProcessor::captureNoteEvents(NoteSource& source, const PitchDetector::FrameResult& frame,
+                                                 bool isRecording)
 {
-    if (recordedNotes_.empty())
+    NoteEvent events[NoteSegmenter::maxEventsPerBlock];
+    const int numEvents = source.segmenter.processBlock(frame,
+                                                        source.detector->getInputLevel(),
+                                                        source.detector->getStreamPosition(),
+                                                        events);
+
+    if (keyEstimatorSource_ == LiveKeySource::notes)
     {
-        detectedKey_ = "Unknown";
-        return;
+        for (int i = 0; i < numEvents; ++i)
+            if (!events[i].isSounding())
+                keyEstimator_.addNote(events[i]);
     }
 
-    // Count pitch class occurrences (0-11, where C=0)
-    std::array<int, 12> pitchClassCounts = {0};
+    if (isRecording)
+        recordNoteEvents(source, events, numEvents);
+}
 
-    for (const auto& note : recordedNotes_)
+void MonolithMaestroProcessor::updateRecordingSession()
+{
+    // A new session was started on the message thread - reset per-session state
+    const auto sessionId = recorder_.getSessionId();
+    if (sessionId != audioSessionId_)
     {
-        int pc = noteToPitchClass(note);
-        if (pc >= 0 && pc < 12)
-        {
-            pitchClassCounts[pc]++;
-        }
+        audioSessionId_ = sessionId;
+        recordingStartSample_ = pitchDetector_.getStreamPosition();
+
+        // A take opens with whatever chord is already sounding
+        if (chordRecognizer_.getCurrentChord().isValid())
+            recordChord(chordRecognizer_.getCurrentChord(), recordingStartSample_);
     }
 
-    // Define major and minor scale patterns (intervals from root)
-    const std::array<int, 7> majorScale = {0, 2, 4, 5, 7, 9, 11};
-    const std::array<int, 7> minorScale = {0, 2, 3, 5, 7, 8, 10};
+    recordedSamples_.store(pitchDetector_.getStreamPosition() - recordingStartSample_,
+                           std::memory_order_relaxed);
 
-    // Score each possible key
-    int bestScore = -1000;
-    juce::String bestKey = "Unknown";
+    const auto endPosition = getTimelinePosition(pitchDetector_.getStreamPosition());
+    if (endPosition.isValid)
+        recordedEndPpq_.store(endPosition.ppq, std::memory_order_relaxed);
+}
 
-    for (int root = 0; root < 12; ++root)
+void MonolithMaestroProcessor::recordNoteEvents(NoteSource& source, NoteEvent* events, int numEvents)
+{
+    for (int i = 0; i < numEvents; ++i)
     {
-        // Score major key
-        int majorScore = 0;
-        for (int interval : majorScale)
-        {
-            int pc = (root + interval) % 12;
-            majorScore += pitchClassCounts[pc] * 2; // Notes in scale get bonus
-        }
+        auto& event = events[i];
 
-        // Penalty for notes NOT in scale
-        for (int pc = 0; pc < 12; ++pc)
-        {
-            bool inScale = false;
-            for (int interval : majorScale)
-            {
-                if (pc == (root + interval) % 12)
-                {
-                    inScale = true;
-                    break;
-                }
-            }
-            if (!inScale)
-            {
-                majorScore -= pitchClassCounts[pc]; // Penalty for chromatic notes
-            }
-        }
+        // A note that ended before the take started isn't part of it
+        if (!event.isSounding() && event.offsetSample <= recordingStartSample_)
+            continue;
 
-        if (majorScore > bestScore)
-        {
-            bestScore = majorScore;
-            bestKey = pitchClassToNoteName(root) + " Major";
-        }
+        stampHostTime(source, event);
 
-        // Score minor key
-        int minorScore = 0;
-        for (int interval : minorScale)
-        {
-            int pc = (root + interval) % 12;
-            minorScore += pitchClassCounts[pc] * 2;
-        }
+        // Session-relative timestamps (a note already sounding at the start begins at 0)
+        event.onsetSample = juce::jmax((juce::int64) 0, event.onsetSample - recordingStartSample_);
+        if (!event.isSounding())
+            event.offsetSample = juce::jmax(event.onsetSample, event.offsetSample - recordingStartSample_);
 
-        for (int pc = 0; pc < 12; ++pc)
-        {
-            bool inScale = false;
-            for (int interval : minorScale)
-            {
-                if (pc == (root + interval) % 12)
-                {
-                    inScale = true;
-                    break;
-                }
-            }
-            if (!inScale)
-            {
-                minorScore -= pitchClassCounts[pc];
-            }
-        }
+        event.sessionId = audioSessionId_;
+        event.sourceChannel = source.sourceChannel;
+        recorder_.pushEvent(event);
+    }
+}
 
-        if (minorScore > bestScore)
-        {
-            bestScore = minorScore;
-            bestKey = pitchClassToNoteName(root) + " Minor";
-        }
+void MonolithMaestroProcessor::recordChord(const DetectedChord& chord, juce::int64 streamSample)
+{
+    ChordEvent event;
+    event.onsetSample = juce::jmax((juce::int64) 0, streamSample - recordingStartSample_);
+    event.sessionId = audioSessionId_;
+    event.root = (juce::int8) chord.root;
+    event.quality = (juce::int8) chord.quality;
+    event.confidence = chord.confidence;
+
+    const auto position = getTimelinePosition(juce::jmax(streamSample, recordingStartSample_));
+    event.hasHostTime = position.isValid;
+
+    if (event.hasHostTime)
+    {
+        event.onsetPpq = position.ppq;
+        event.onsetSeconds = position.seconds;
+        event.bpm = (float) position.bpm;
+        event.bar = position.bar;
     }
 
-    detectedKey_ = bestKey;
+    recorder_.pushChord(event);
 }
 
-int MonolithMaestroProcessor::noteToPitchClass(const juce::String& noteName) const
+HostTimeline::Position MonolithMaestroProcessor::getTimelinePosition(juce::int64 streamSample) const
 {
-    if (noteName.isEmpty())
-        return -1;
+    // The host's transport wins; the tracked beat fills in when it isn't running
+    const auto hostPosition = hostTimeline_.getPosition(streamSample);
+    return hostPosition.isValid ? hostPosition : beatTracker_.getPosition(streamSample);
+}
 
-    // Extract note name without octave (e.g., "C5" -> "C", "F#4" -> "F#")
-    juce::String noteOnly;
-    for (int i = 0; i < noteName.length(); ++i)
+void MonolithMaestroProcessor::stampHostTime(NoteSource& source, NoteEvent& event)
+{
+    // A finished note keeps the onset stamped when it started, however long ago that was
+    const bool isOpenNote = !event.isSounding() && source.openNoteOnset.isValid
+                            && event.onsetSample == source.openNoteOnsetSample;
+    const auto onset = isOpenNote ? source.openNoteOnset : getTimelinePosition(event.onsetSample);
+
+    if (event.isSounding())
     {
-        if (noteName[i] >= '0' && noteName[i] <= '9')
-            break;
-        noteOnly += noteName[i];
+        source.openNoteOnset = onset;
+        source.openNoteOnsetSample = event.onsetSample;
     }
 
-    // Map to pitch class (0-11)
-    if (noteOnly == "C") return 0;
-    if (noteOnly == "C#" || noteOnly == "Db") return 1;
-    if (noteOnly == "D") return 2;
-    if (noteOnly == "D#" || noteOnly == "Eb") return 3;
-    if (noteOnly == "E") return 4;
-    if (noteOnly == "F") return 5;
-    if (noteOnly == "F#" || noteOnly == "Gb") return 6;
-    if (noteOnly == "G") return 7;
-    if (noteOnly == "G#" || noteOnly == "Ab") return 8;
-    if (noteOnly == "A") return 9;
-    if (noteOnly == "A#" || noteOnly == "Bb") return 10;
-    if (noteOnly == "B") return 11;
+    event.hasHostTime = onset.isValid;
+    if (!event.hasHostTime)
+        return;
+
+    event.onsetPpq = onset.ppq;
+    event.onsetSeconds = onset.seconds;
+    event.bpm = (float) onset.bpm;
+    event.bar = onset.bar;
 
-    return -1;
+    const auto offset = getTimelinePosition(event.offsetSample);
+    event.offsetPpq = event.isSounding() || !offset.isValid ? onset.ppq : juce::jmax(onset.ppq, offset.ppq);
 }
 
-juce::String MonolithMaestroProcessor::pitchClassToNoteName(int pitchClass) const
+void MonolithMaestroProcessor::startRecording()
 {
-    const char* names[] = {"C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"};
+    recordedSamples_.store(0, std::memory_order_relaxed);
+    recordedEndPpq_.store(0.0, std::memory_order_relaxed);
+    recorder_.startSession(getSampleRate());
+    isRecording_.store(true);
+}
+
+void MonolithMaestroProcessor::stopRecording(std::function<void(RecordingHandle)> onStopped,
+                                             std::function<void(RecordingHandle)> onKeysAnalysed)
+{
+    isRecording_.store(false);
+
+    const double sampleRate = getSampleRate() > 0.0 ? getSampleRate() : 44100.0;
+    juce::WeakReference<MonolithMaestroProcessor> processor(this);
+
+    // The recorder finishes the take on its own thread, so stopping never waits on its disk I/O
+    recorder_.stopSession(recordedSamples_.load(std::memory_order_relaxed),
+                          recordedEndPpq_.load(std::memory_order_relaxed),
+                          [processor, sampleRate, onStopped = std::move(onStopped),
+                           onKeysAnalysed = std::move(onKeysAnalysed)](std::shared_ptr<RecordingStore> recording)
+    {
+        if (processor == nullptr)
+            return;
+
+        if (onStopped != nullptr)
+            onStopped(recording);
+
+        // Overall key and key per section, for takes that modulate. The results are stored
+        // on the message thread, where the display reads them, once the job has finished reading the store
+        KeyTimeline::analyzeAsync(processor->analysisPool_, recording, sampleRate, {},
+                                  [processor, recording, onKeysAnalysed](KeyTimeline::Analysis analysis)
+        {
+            if (processor == nullptr)
+                return;
 
-    if (pitchClass >= 0 && pitchClass < 12)
-        return names[pitchClass];
+            recording->setKey(analysis.key.key, analysis.key.confidence);
+            recording->setKeyRegions(std::move(analysis.regions));
 
-    return "?";
+            if (onKeysAnalysed != nullptr)
+                onKeysAnalysed(recording);
+        });
+    });
 }
 
 //==============================================================================
@@ -2,6 +2,16 @@
 
 #include <juce_audio_processors/juce_audio_processors.h>
 #include "PitchDetector.h"
+#include "BeatTracker.h"
+#include "ChordRecognizer.h"
+#include "DetectorWorker.h"
+#include "HostTimeline.h"
+#include "KeyEstimator.h"
+#include "KeyTimeline.h"
+#include "LiveMidiOutput.h"
+#include "NoteRecorder.h"
+#include "NoteSegmenter.h"
+#include "StringDetectorBank.h"
 
 //==============================================================================
 /**
@@ -49,20 +59,179 @@ public:
     /** Checks if audio is currently active (above noise threshold). */
     bool isAudioActive() const { return audioActive; }
 
-    /** Gets currently detected notes from the pitch detector. */
+    /** Gets currently detected notes, tagged with the channel they were detected on. */
     std::vector<DetectedNote> getDetectedNotes() const;
 
+    /** Gets the chord currently sounding. Lock-free. */
+    DetectedChord getDetectedChord() const { return chordRecognizer_.getChord(); }
+
+    /** Gets the tempo tracked from the input, or 0 if not locked. Lock-free. */
+    double getTrackedTempo() const { return beatTracker_.getTempo(); }
+
+    /** Gets the worst-case analysis callback time in microseconds. */
+    double getWorstCaseAnalysisCallbackMicros() const { return pitchDetector_.getWorstCaseCallbackMicros(); }
+
+    /**
+     * Enables picking notes from the harmonic part of the spectrum only, so
+     * attacks and percussion don't trigger spurious notes. Applied at the next
+     * prepareToPlay().
+     */
+    void setHarmonicSeparationEnabled(bool shouldSeparate)
+    {
+        forEachDetector([shouldSeparate](PitchDetector& detector) { detector.setHarmonicSeparationEnabled(shouldSeparate); });
+    }
+
+    /**
+     * Enables learning the background noise spectrum and detecting notes
+     * relative to it rather than at a fixed level. Applied at the next
+     * prepareToPlay().
+     */
+    void setNoiseProfileEnabled(bool shouldUseProfile)
+    {
+        forEachDetector([shouldUseProfile](PitchDetector& detector) { detector.setNoiseProfileEnabled(shouldUseProfile); });
+    }
+
+    /**
+     * Sets the rumble high-pass and mains hum notches applied before analysis.
+     * Applied at the next prepareToPlay().
+     */
+    void setPreFilterSettings(const PreFilter::Settings& settings)
+    {
+        forEachDetector([&settings](PitchDetector& detector) { detector.setPreFilterSettings(settings); });
+    }
+
+    /**
+     * Sets how much of the sidechain accompaniment is subtracted from the input,
+     * relative to its estimated bleed (see PitchDetector::setReferenceSuppression()).
+     */
+    void setReferenceSuppression(float amount)
+    {
+        forEachDetector([amount](PitchDetector& detector) { detector.setReferenceSuppression(amount); });
+    }
+
+    //==============================================================================
+    // Input channels
+
+    /** Which input channel(s) the pitch detector analyses. */
+    enum class ChannelStrategy
+    {
+        left,           ///< First channel only
+        right,          ///< Second channel only
+        mid,            ///< (L + R) / 2, for sources spread across both channels
+        side,           ///< (L - R) / 2, e.g. to drop a centred source
+        independent,    ///< One detector per channel, each with its own note track and MIDI channel
+        loudest         ///< Whichever channel is clearly louder, switched block by block
+    };
+
+    /**
+     * Sets which input channel(s) are analysed. A mono input is analysed as
+     * is whatever the strategy. Detected notes are tagged with their channel
+     * (-1 for mid and side). With the independent strategy, both channels'
+     * notes are output and recorded, the second channel's on the next MIDI
+     * channel up. Applied at the next prepareToPlay().
+     */
+    void setChannelStrategy(ChannelStrategy strategy) { requestedChannelStrategy_.store(strategy, std::memory_order_relaxed); }
+
+    /** Gets the channel strategy requested for the next prepareToPlay(). */
+    ChannelStrategy getChannelStrategy() const { return requestedChannelStrategy_.load(std::memory_order_relaxed); }
+
+    /**
+     * Sets the open-string notes of a divided pickup, lowest string first
+     * (see StringDetectorBank::setTuning()). Applied at the next prepareToPlay().
+     *
+     * A main input of StringDetectorBank::minStrings to maxStrings channels is
+     * taken as one string per channel: every string gets its own detector and
+     * getDetectedNotes() reports one note per sounding string, tagged with its
+     * string index. Each string also has its own note track and plays on its
+     * own MIDI channel, counting up from the first. Chords, the spectrum key
+     * and beats follow the sum of the strings, which is also what the output
+     * passes through.
+     */
+    void setStringTuning(const std::vector<int>& openStringNotes) { stringDetectors_.setTuning(openStringNotes); }
+
+    /** Gets the number of strings analysed separately (0 unless the input is a divided pickup). */
+    int getNumAnalysedStrings() const { return stringDetectors_.getNumStrings(); }
+
+    //==============================================================================
+    // MIDI output
+
+    /**
+     * Enables or disables live MIDI output of detected notes (message thread).
+     * Placing messages at their frame ends needs the analysis spread reported
+     * as latency, so only while output is enabled does the plugin report it
+     * and delay its pass-through audio to match; the host is told on a change.
+     */
+    void setMidiOutputEnabled(bool shouldBeEnabled);
+
+    /** Checks if live MIDI output is enabled. */
+    bool isMidiOutputEnabled() const { return noteSources_[0].midiOutput.isEnabled(); }
+
+    /** Selects plain notes or MPE (per-note pitch bend and pressure) output. */
+    void setMidiOutputMode(LiveMidiOutput::OutputMode mode)
+    {
+        for (auto& source : noteSources_)
+            source.midiOutput.setOutputMode(mode);
+    }
+
+    /** Gets the live MIDI output mode. */
+    LiveMidiOutput::OutputMode getMidiOutputMode() const { return noteSources_[0].midiOutput.getOutputMode(); }
+
+    /**
+     * Sets how MPE expression is thinned.
+     *
+     * @param pitchBendCents Minimum pitch change before a new pitch bend is sent
+     * @param pressureSteps Minimum pressure change (0-127) before new pressure is sent
+     * @param maxUpdatesPerSecond Rate limit for each of the two streams
+     */
+    void setMpeExpressionThinning(float pitchBendCents, int pressureSteps, double maxUpdatesPerSecond)
+    {
+        for (auto& source : noteSources_)
+        {
+            source.midiOutput.setExpressionThresholds(pitchBendCents, pressureSteps);
+            source.midiOutput.setMaxExpressionRate(maxUpdatesPerSecond);
+        }
+    }
+
     //==============================================================================
     // Recording functionality
 
     /** Starts recording detected notes. */
     void startRecording();
 
-    /** Stops recording and returns the recorded notes sequence. */
-    std::vector<juce::String> stopRecording();
+    /**
+     * Stops recording. The take is finished on the recorder's thread and
+     * handed over without copying events; its key and key regions are then
+     * analysed on a background thread, since a long take has to be read back
+     * from disk. Callbacks still outstanding when the processor is destroyed
+     * are dropped.
+     *
+     * @param onStopped Called on the message thread with the finished recording
+     * @param onKeysAnalysed Called on the message thread once the key and key regions are stored, or nullptr
+     */
+    void stopRecording(std::function<void(RecordingHandle)> onStopped,
+                       std::function<void(RecordingHandle)> onKeysAnalysed = nullptr);
+
+    /** Sets the event memory a recording may keep resident before spilling to disk. */
+    void setRecordingMemoryCap(size_t bytes) { recorder_.setMemoryCap(bytes); }
+
+    /** Sets how recordings are written to their Standard MIDI File. Takes effect at the next recording. */
+    void setRecordingMidiFileOptions(const MidiFileWriter::Options& options) { recorder_.setMidiFileOptions(options); }
+
+    /** Gets the live key estimate from the notes played recently. Lock-free. */
+    KeyEstimator::Estimate getLiveKey() const { return keyEstimator_.getEstimate(); }
+
+    /** Sets how quickly the live key estimate forgets old notes (weight half-life). */
+    void setLiveKeyHalfLife(double seconds) { keyEstimator_.setHalfLife(seconds); }
 
-    /** Gets the detected musical key from the last recording. */
-    juce::String getDetectedKey() const { return detectedKey_; }
+    /** What the live key estimate listens to. */
+    enum class LiveKeySource
+    {
+        notes,      ///< Finished notes from the note track(s)
+        spectrum    ///< Every frame's chroma (hears chords and accompaniment too)
+    };
+
+    /** Sets what the live key estimate listens to. Switching starts the estimate afresh. */
+    void setLiveKeySource(LiveKeySource source) { liveKeySource_.store(source, std::memory_order_relaxed); }
 
     /** Checks if currently recording. */
     bool isRecording() const { return isRecording_.load(); }
@@ -71,24 +240,123 @@ private:
     //==============================================================================
     std::atomic<bool> audioActive { false };           ///< Audio activity flag
     const float activityThreshold = 0.001f;            ///< RMS threshold for activity
-    PitchDetector pitchDetector_;                      ///< Pitch detection engine
+    PitchDetector pitchDetector_;                      ///< Pitch detection engine (feeds chords, and the note track and MIDI unless split)
+
+    // Input channels
+    static constexpr float channelLevelSmoothing_ = 0.3f;  ///< Per-block smoothing of the loudest-channel levels
+    static constexpr float channelSwitchRatio_ = 1.41f;    ///< Level ratio (3 dB) before the loudest channel changes
+    std::atomic<ChannelStrategy> requestedChannelStrategy_ { ChannelStrategy::left }; ///< For the next prepareToPlay()
+    ChannelStrategy channelStrategy_ = ChannelStrategy::left;   ///< Strategy in use
+    bool analyseSecondChannel_ = false;                ///< Independent strategy on a stereo input
+    PitchDetector secondChannelDetector_;              ///< Second channel's detector (independent strategy)
+    DetectorWorker detectorWorker_;                    ///< Runs secondChannelDetector_ alongside pitchDetector_
+    juce::AudioBuffer<float> analysisBuffer_;          ///< Mid or side mix of the input
+    std::array<float, 2> channelLevels_ {};            ///< Smoothed RMS of each channel (loudest strategy)
+    int loudestChannel_ = 0;                           ///< Channel the loudest strategy analyses
+    StringDetectorBank stringDetectors_;               ///< One detector per string of a divided pickup
+
+    /** One detector's path to a note track and MIDI channel. */
+    struct NoteSource
+    {
+        const PitchDetector* detector = nullptr;       ///< Detector whose frames it follows
+        juce::int8 sourceChannel = -1;                 ///< Tag for its recorded notes (-1 if it is the only source)
+        NoteSegmenter segmenter;                       ///< Frames -> note events
+        LiveMidiOutput midiOutput;                     ///< Detected notes -> MIDI out
+        juce::uint32 lastFrameIndex = 0;               ///< Last frame passed to MIDI and note capture
+        HostTimeline::Position openNoteOnset;          ///< Host time of the sounding note's onset
+        juce::int64 openNoteOnsetSample = 0;           ///< Stream position of that onset
+    };
+
+    static constexpr int maxNoteSources_ = StringDetectorBank::maxStrings; ///< Strings, or channels analysed independently
+    std::array<NoteSource, maxNoteSources_> noteSources_; ///< Note tracks and MIDI, one per detector analysed
+    int numNoteSources_ = 1;                           ///< Sources in use (fixed by prepareToPlay())
+    static_assert(maxNoteSources_ <= NoteEvent::maxSources, "Every source needs its own recorded note slot");
+
+    /** Delays the pass-through audio by the reported latency so it stays aligned. */
+    juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::None> passThroughDelay_;
+    int analysisSpreadSamples_ = 0;                    ///< Latency MIDI output needs (fixed by prepareToPlay())
+    std::atomic<int> latencySamples_ { 0 };            ///< Latency reported to the host
+    int appliedLatencySamples_ = 0;                    ///< Latency the audio thread compensates
 
     // Recording state
     std::atomic<bool> isRecording_ { false };          ///< Recording active flag
-    std::vector<juce::String> recordedNotes_;          ///< Recorded note sequence
-    juce::String lastRecordedNote_;                    ///< Last note to avoid duplicates
-    juce::String detectedKey_;                         ///< Detected musical key
-    juce::CriticalSection recordingLock_;              ///< Thread safety for recording
+    NoteRecorder recorder_;                            ///< Lock-free event capture
+    std::atomic<juce::int64> recordedSamples_ { 0 };   ///< Length of the current session
+    std::atomic<double> recordedEndPpq_ { 0.0 };       ///< Host timeline position of the session end
+    juce::ThreadPool analysisPool_ { 1 };              ///< Key analysis of finished recordings
+
+    // Audio-thread note state
+    KeyEstimator keyEstimator_;                        ///< Note events or chroma -> live key
+    std::atomic<LiveKeySource> liveKeySource_ { LiveKeySource::spectrum }; ///< Requested key input
+    LiveKeySource keyEstimatorSource_ = LiveKeySource::spectrum;           ///< Input keyEstimator_ currently holds
+    ChordRecognizer chordRecognizer_;                  ///< Chroma -> current chord
+    juce::uint32 lastChromaFrameIndex_ = 0;            ///< Last detector frame whose chroma was used
+    HostTimeline hostTimeline_;                        ///< Stream positions -> host PPQ/seconds/bar
+    BeatTracker beatTracker_;                          ///< Stream positions -> tracked beats, without a transport
+    juce::uint32 audioSessionId_ = 0;                  ///< Session the state below belongs to
+    juce::int64 recordingStartSample_ = 0;             ///< Detector stream position at session start
 
     //==============================================================================
-    /** Analyzes recorded notes and detects the musical key. */
-    void analyzeKey();
+    /** Applies a setting to every pitch detector. */
+    template <typename Setter>
+    void forEachDetector(Setter&& setter)
+    {
+        setter(pitchDetector_);
+        setter(secondChannelDetector_);
+        stringDetectors_.forEachDetector(setter);
+    }
+
+    /**
+     * Feeds the input channels to the beat tracker and pitch detector(s) according to the channel
+     * strategy, passing every new frame on as it is published (audio thread).
+     *
+     * @param buffer        Block with the main input in its first channels
+     * @param referenceData Sidechain accompaniment for the block, or nullptr
+     * @param midiMessages  Host buffer for the live MIDI output
+     */
+    void analyseInput(const juce::AudioBuffer<float>& buffer, const float* referenceData,
+                      juce::MidiBuffer& midiMessages);
+
+    /**
+     * Passes the frames published since the last call to the chord and key analysis,
+     * and every source's frames to its MIDI output and note capture (audio thread).
+     *
+     * @param blockStartSample Detector stream position of the host block's first sample
+     * @param numSamples       Length of the host block
+     * @param midiMessages     Host buffer for the live MIDI output
+     */
+    void consumeNewFrames(juce::int64 blockStartSample, int numSamples, juce::MidiBuffer& midiMessages);
+
+    /** Switches the MIDI output, host timeline and pass-through delay to a new latency (audio thread). */
+    void applyLatency(int latencySamples);
+
+    /** Updates the channel levels over a stretch of the block and returns the channel to analyse (audio thread). */
+    int selectLoudestChannel(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+    /**
+     * Segments a source's detector result into note events for the key estimate and recorder (audio thread).
+     *
+     * @param source      Source the frame comes from
+     * @param frame       Detector result
+     * @param isRecording Pass the events to the recorder
+     */
+    void captureNoteEvents(NoteSource& source, const PitchDetector::FrameResult& frame, bool isRecording);
+
+    /** Resets per-session state when a new session has started and tracks the session length (audio thread, while recording). */
+    void updateRecordingSession();
+
+    /** Passes a block's note events to the recorder (audio thread, while recording). */
+    void recordNoteEvents(NoteSource& source, NoteEvent* events, int numEvents);
+
+    /** Passes a chord change at a detector stream position to the recorder (audio thread, while recording). */
+    void recordChord(const DetectedChord& chord, juce::int64 streamSample);
 
-    /** Converts note name to pitch class (0-11, C=0). */
-    int noteToPitchClass(const juce::String& noteName) const;
+    /** Converts a stream position to the host timeline, or the tracked beat when the transport is stopped (audio thread). */
+    HostTimeline::Position getTimelinePosition(juce::int64 streamSample) const;
 
-    /** Converts pitch class to note name. */
-    juce::String pitchClassToNoteName(int pitchClass) const;
+    /** Fills an event's host timeline fields from stream positions (audio thread). */
+    void stampHostTime(NoteSource& source, NoteEvent& event);
 
+    JUCE_DECLARE_WEAK_REFERENCEABLE(MonolithMaestroProcessor)
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MonolithMaestroProcessor)
 };
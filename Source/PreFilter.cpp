@@ -0,0 +1,150 @@
+#include "PreFilter.h"
+#include <cmath>
+#include <cstring>
+
+#if JUCE_INTEL
+ #include <xmmintrin.h>
+#elif JUCE_ARM && (defined (__ARM_NEON) || defined (__ARM_NEON__) || defined (_M_ARM64))
+ #include <arm_neon.h>
+ #define MONOLITH_PREFILTER_NEON 1
+#endif
+
+namespace
+{
+    //==============================================================================
+    // The few 4-lane operations the cascade needs. A plain array fallback keeps
+    // other targets building; it computes the same thing a lane at a time.
+   #if JUCE_INTEL
+    using Vector = __m128;
+    inline Vector load(const float* p)                { return _mm_load_ps(p); }
+    inline void store(float* p, Vector v)             { _mm_store_ps(p, v); }
+    inline Vector add(Vector a, Vector b)             { return _mm_add_ps(a, b); }
+    inline Vector sub(Vector a, Vector b)             { return _mm_sub_ps(a, b); }
+    inline Vector mul(Vector a, Vector b)             { return _mm_mul_ps(a, b); }
+    inline float lastLane(Vector v)                   { return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))); }
+
+    /** { sample, v[0], v[1], v[2] } */
+    inline Vector shiftIn(Vector v, float sample)
+    {
+        return _mm_move_ss(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 1, 0, 0)), _mm_set_ss(sample));
+    }
+   #elif MONOLITH_PREFILTER_NEON
+    using Vector = float32x4_t;
+    inline Vector load(const float* p)                { return vld1q_f32(p); }
+    inline void store(float* p, Vector v)             { vst1q_f32(p, v); }
+    inline Vector add(Vector a, Vector b)             { return vaddq_f32(a, b); }
+    inline Vector sub(Vector a, Vector b)             { return vsubq_f32(a, b); }
+    inline Vector mul(Vector a, Vector b)             { return vmulq_f32(a, b); }
+    inline float lastLane(Vector v)                   { return vgetq_lane_f32(v, 3); }
+    inline Vector shiftIn(Vector v, float sample)     { return vextq_f32(vdupq_n_f32(sample), v, 3); }
+   #else
+    struct Vector { float lane[4]; };
+    inline Vector load(const float* p)                { Vector v; std::memcpy(v.lane, p, sizeof(v.lane)); return v; }
+    inline void store(float* p, Vector v)             { std::memcpy(p, v.lane, sizeof(v.lane)); }
+    inline Vector add(Vector a, Vector b)             { for (int i = 0; i < 4; ++i) a.lane[i] += b.lane[i]; return a; }
+    inline Vector sub(Vector a, Vector b)             { for (int i = 0; i < 4; ++i) a.lane[i] -= b.lane[i]; return a; }
+    inline Vector mul(Vector a, Vector b)             { for (int i = 0; i < 4; ++i) a.lane[i] *= b.lane[i]; return a; }
+    inline float lastLane(Vector v)                   { return v.lane[3]; }
+    inline Vector shiftIn(Vector v, float sample)     { return { { sample, v.lane[0], v.lane[1], v.lane[2] } }; }
+   #endif
+}
+
+//==============================================================================
+void PreFilter::prepare(double sampleRate, const Settings& settings)
+{
+    // Every section starts as a pass-through
+    b0_.fill(1.0f);
+    b1_.fill(0.0f);
+    b2_.fill(0.0f);
+    a1_.fill(0.0f);
+    a2_.fill(0.0f);
+    numActiveSections_ = 0;
+
+    const double nyquist = sampleRate * 0.5;
+
+    // Biquad designs from the RBJ audio EQ cookbook
+    if (settings.highPassHz > 0.0f && settings.highPassHz < nyquist)
+    {
+        const double w0 = juce::MathConstants<double>::twoPi * settings.highPassHz / sampleRate;
+        const double alpha = std::sin(w0) / juce::MathConstants<double>::sqrt2;  // Butterworth: Q = 1/√2
+        const double cosW0 = std::cos(w0);
+
+        addSection({ (1.0 + cosW0) * 0.5, -(1.0 + cosW0), (1.0 + cosW0) * 0.5 },
+                   { 1.0 + alpha, -2.0 * cosW0, 1.0 - alpha });
+    }
+
+    if (settings.mainsHz > 0.0f && settings.notchQ > 0.0f)
+    {
+        for (int harmonic = 1; harmonic <= settings.numMainsHarmonics && numActiveSections_ < numSections_; ++harmonic)
+        {
+            const double frequency = static_cast<double>(settings.mainsHz) * harmonic;
+            if (frequency >= nyquist)
+                break;
+
+            const double w0 = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+            const double alpha = std::sin(w0) / (2.0 * settings.notchQ);
+            const double cosW0 = std::cos(w0);
+
+            addSection({ 1.0, -2.0 * cosW0, 1.0 },
+                       { 1.0 + alpha, -2.0 * cosW0, 1.0 - alpha });
+        }
+    }
+
+    reset();
+}
+
+void PreFilter::reset()
+{
+    state1_.fill(0.0f);
+    state2_.fill(0.0f);
+    outputs_.fill(0.0f);
+}
+
+void PreFilter::process(const float* input, float* output, int numSamples)
+{
+    if (!isActive())
+    {
+        if (output != input)
+            std::memmove(output, input, static_cast<size_t>(numSamples) * sizeof(float));
+        return;
+    }
+
+    const auto b0 = load(b0_.data());
+    const auto b1 = load(b1_.data());
+    const auto b2 = load(b2_.data());
+    const auto a1 = load(a1_.data());
+    const auto a2 = load(a2_.data());
+    auto state1 = load(state1_.data());
+    auto state2 = load(state2_.data());
+    auto outputs = load(outputs_.data());
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        // Section 0 takes the new sample, section j what section j - 1 produced a step ago
+        const auto in = shiftIn(outputs, input[n]);
+
+        // One transposed direct form II step in every section at once
+        const auto y = add(mul(b0, in), state1);
+        state1 = sub(add(mul(b1, in), state2), mul(a1, y));
+        state2 = sub(mul(b2, in), mul(a2, y));
+        outputs = y;
+
+        output[n] = lastLane(y);
+    }
+
+    store(state1_.data(), state1);
+    store(state2_.data(), state2);
+    store(outputs_.data(), outputs);
+}
+
+//==============================================================================
+void PreFilter::addSection(const std::array<double, 3>& b, const std::array<double, 3>& a)
+{
+    const auto lane = static_cast<size_t>(numActiveSections_++);
+
+    b0_[lane] = static_cast<float>(b[0] / a[0]);
+    b1_[lane] = static_cast<float>(b[1] / a[0]);
+    b2_[lane] = static_cast<float>(b[2] / a[0]);
+    a1_[lane] = static_cast<float>(a[1] / a[0]);
+    a2_[lane] = static_cast<float>(a[2] / a[0]);
+}
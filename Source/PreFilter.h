@@ -0,0 +1,90 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+
+//==============================================================================
+/**
+ * IIR clean-up applied to the input ahead of pitch analysis: a rumble
+ * high-pass plus notches at the mains frequency and its harmonics.
+ *
+ * The chain is a cascade of transposed direct form II biquads, one per lane
+ * of a 4-wide SIMD register. Rather than running the sections one after the
+ * other, every step advances all of them at once, each on what the section
+ * before it produced a step earlier. A sample then costs one vector biquad
+ * update instead of four scalar ones, for numSections_ - 1 samples of delay.
+ * Sections the settings don't use pass their input straight through.
+ */
+class PreFilter
+{
+public:
+    //==============================================================================
+    /**
+     * Filter chain configuration. A zero frequency disables that part; both
+     * are off by default, so a detector only pays for the chain (and its
+     * delay) when the input actually carries rumble or hum.
+     */
+    struct Settings
+    {
+        float highPassHz = 0.0f;        ///< Rumble high-pass cutoff (12 dB/octave), e.g. 30 Hz to stay below the lowest bass string
+        float mainsHz = 0.0f;           ///< Mains frequency to notch (50 or 60), 0 for none
+        int numMainsHarmonics = 3;      ///< Notches at mainsHz, 2 * mainsHz, ... (up to numSections_ - 1)
+        float notchQ = 30.0f;           ///< Notch sharpness (centre frequency / bandwidth)
+    };
+
+    //==============================================================================
+    PreFilter() = default;
+    ~PreFilter() = default;
+
+    /**
+     * Computes the section coefficients and clears the filter state.
+     *
+     * @param sampleRate Sample rate in Hz
+     * @param settings   Chain to build
+     */
+    void prepare(double sampleRate, const Settings& settings);
+
+    /** Clears the filter state. */
+    void reset();
+
+    /**
+     * Filters a run of samples.
+     *
+     * @param input      Samples to filter
+     * @param output     Filtered samples (may be the same as input)
+     * @param numSamples Number of samples
+     */
+    void process(const float* input, float* output, int numSamples);
+
+    /** Returns true if any section does more than pass its input through. */
+    bool isActive() const { return numActiveSections_ > 0; }
+
+    /** Gets the delay the section skew adds, in samples (0 when inactive). */
+    int getLatencySamples() const { return isActive() ? numSections_ - 1 : 0; }
+
+    static constexpr int numSections_ = 4;    ///< One high-pass plus up to three notches
+
+private:
+    //==============================================================================
+    using Lanes = std::array<float, numSections_>;
+
+    /**
+     * Sets the coefficients of the next unused section, normalised by a0.
+     *
+     * @param b Feed-forward coefficients b0, b1, b2
+     * @param a Feedback coefficients a0, a1, a2
+     */
+    void addSection(const std::array<double, 3>& b, const std::array<double, 3>& a);
+
+    alignas(16) Lanes b0_ {};                 ///< Per-section coefficients, one section per lane
+    alignas(16) Lanes b1_ {};
+    alignas(16) Lanes b2_ {};
+    alignas(16) Lanes a1_ {};
+    alignas(16) Lanes a2_ {};
+    alignas(16) Lanes state1_ {};             ///< Transposed direct form II state
+    alignas(16) Lanes state2_ {};
+    alignas(16) Lanes outputs_ {};            ///< Each section's output from the previous step
+    int numActiveSections_ = 0;               ///< Sections that aren't pass-through
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PreFilter)
+};
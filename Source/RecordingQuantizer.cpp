@@ -0,0 +1,63 @@
+#include "RecordingQuantizer.h"
+#include <juce_events/juce_events.h>
+#include <cmath>
+
+//==============================================================================
+RecordingHandle RecordingQuantizer::quantize(const RecordingStore& source, const Settings& settings)
+{
+    auto result = std::make_shared<RecordingStore>(std::make_shared<RecordingStore::ChunkPool>(),
+                                                   source.getMaxResidentChunks());
+
+    source.forEachEvent([&](const NoteEvent& event)
+    {
+        if (!event.hasHostTime || settings.gridPpq <= 0.0)
+        {
+            result->append(event);
+            return;
+        }
+
+        auto quantized = event;
+        quantized.onsetPpq = snap(event.onsetPpq, settings);
+
+        // Onset seconds follow the PPQ shift at the note's tempo
+        const double shiftPpq = quantized.onsetPpq - event.onsetPpq;
+        quantized.onsetSeconds = event.onsetSeconds + shiftPpq * 60.0 / juce::jmax(1.0f, event.bpm);
+
+        quantized.offsetPpq = settings.quantizeOffsets ? snap(event.offsetPpq, settings)
+                                                       : event.offsetPpq + shiftPpq;
+
+        // A note snapped to zero length keeps one grid step rather than vanishing
+        if (quantized.offsetPpq <= quantized.onsetPpq)
+            quantized.offsetPpq = quantized.onsetPpq + settings.gridPpq;
+
+        result->append(quantized);
+    });
+
+    result->finish();
+    return result;
+}
+
+void RecordingQuantizer::quantizeAsync(juce::ThreadPool& pool, RecordingHandle source, const Settings& settings,
+                                       std::function<void(RecordingHandle)> onFinished)
+{
+    pool.addJob([source = std::move(source), settings, onFinished = std::move(onFinished)]
+    {
+        auto quantized = quantize(*source, settings);
+
+        // The pool's owner is going away; nobody is left to take the result
+        if (auto* job = juce::ThreadPoolJob::getCurrentThreadPoolJob(); job != nullptr && job->shouldExit())
+            return;
+
+        juce::MessageManager::callAsync([quantized = std::move(quantized), onFinished]
+        {
+            onFinished(quantized);
+        });
+    });
+}
+
+//==============================================================================
+double RecordingQuantizer::snap(double ppq, const Settings& settings)
+{
+    const double target = std::round(ppq / settings.gridPpq) * settings.gridPpq;
+    return ppq + (target - ppq) * (double) juce::jlimit(0.0f, 1.0f, settings.strength);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "RecordingStore.h"
+#include <functional>
+
+//==============================================================================
+/**
+ * Snaps a finished recording to the host's musical grid.
+ *
+ * Works only on the host timeline fields (PPQ and seconds); sample positions
+ * are left as captured so the original performance is never lost. Without a
+ * running transport those fields come from the beat tracker, so the grid is
+ * the tracked beat; events recorded before it locked pass through unchanged. The result is a
+ * new store, so the source recording can still be shown or exported as played.
+ *
+ * Quantizing walks every event (and reads spilled ones back from disk), so it
+ * never runs on the audio thread.
+ */
+class RecordingQuantizer
+{
+public:
+    //==============================================================================
+    /** How hard to quantize. */
+    struct Settings
+    {
+        double gridPpq = 0.25;          ///< Grid spacing in quarter notes (0.25 = sixteenths)
+        float strength = 1.0f;          ///< 0 = unchanged, 1 = exactly on the grid
+        bool quantizeOffsets = true;    ///< Also snap note ends (otherwise lengths are kept)
+    };
+
+    /**
+     * Quantizes a recording (blocking; call from a background thread for long sessions).
+     *
+     * @param source Finished recording
+     * @param settings Grid and strength
+     * @return A new recording with quantized host timeline fields
+     */
+    static RecordingHandle quantize(const RecordingStore& source, const Settings& settings);
+
+    /**
+     * Quantizes on a pool thread and delivers the result on the message thread
+     * (nothing is delivered if the pool asks the job to exit).
+     *
+     * @param pool Pool to run on, owned by whoever must outlive the job
+     * @param source Finished recording (kept alive until the job finishes)
+     * @param settings Grid and strength
+     * @param onFinished Called on the message thread with the quantized recording
+     */
+    static void quantizeAsync(juce::ThreadPool& pool, RecordingHandle source, const Settings& settings,
+                              std::function<void(RecordingHandle)> onFinished);
+
+private:
+    /** Moves a PPQ position towards its nearest grid line. */
+    static double snap(double ppq, const Settings& settings);
+};
@@ -0,0 +1,204 @@
+#include "RecordingStore.h"
+#include <limits>
+
+//==============================================================================
+void RecordingStore::ChunkPool::reserve(int numChunks)
+{
+    const juce::ScopedLock lock(lock_);
+
+    while ((int) freeChunks_.size() < numChunks)
+        freeChunks_.push_back(std::make_unique<Chunk>());
+}
+
+std::unique_ptr<RecordingStore::Chunk> RecordingStore::ChunkPool::acquire()
+{
+    {
+        const juce::ScopedLock lock(lock_);
+
+        if (!freeChunks_.empty())
+        {
+            auto chunk = std::move(freeChunks_.back());
+            freeChunks_.pop_back();
+            chunk->numEvents = 0;
+            return chunk;
+        }
+    }
+
+    return std::make_unique<Chunk>();
+}
+
+void RecordingStore::ChunkPool::release(std::unique_ptr<Chunk> chunk)
+{
+    if (chunk == nullptr)
+        return;
+
+    const juce::ScopedLock lock(lock_);
+    freeChunks_.push_back(std::move(chunk));
+}
+
+int RecordingStore::ChunkPool::getNumFreeChunks() const
+{
+    const juce::ScopedLock lock(lock_);
+    return (int) freeChunks_.size();
+}
+
+//==============================================================================
+RecordingStore::RecordingStore(std::shared_ptr<ChunkPool> pool, int maxResidentChunks, int maxChords)
+    : pool_(std::move(pool))
+    , maxResidentChunks_(juce::jmax(1, maxResidentChunks))
+{
+    chunks_.reserve(static_cast<size_t>(maxResidentChunks_ + 1));
+    chords_.reserve(static_cast<size_t>(juce::jmax(0, maxChords)));
+}
+
+RecordingStore::~RecordingStore()
+{
+    for (auto& chunk : chunks_)
+        pool_->release(std::move(chunk));
+
+    spillStream_.reset();
+
+    if (spillFile_.existsAsFile())
+        spillFile_.deleteFile();
+
+    if (midiFile_.existsAsFile())
+        midiFile_.deleteFile();
+}
+
+//==============================================================================
+void RecordingStore::append(const NoteEvent& event)
+{
+    if (chunks_.empty() || chunks_.back()->numEvents == eventsPerChunk)
+    {
+        if ((int) chunks_.size() >= maxResidentChunks_)
+            spillOldestChunk();
+
+        chunks_.push_back(pool_->acquire());
+    }
+
+    auto& chunk = *chunks_.back();
+    chunk.events[static_cast<size_t>(chunk.numEvents++)] = event;
+    ++numResidentEvents_;
+    sessionId_ = event.sessionId;
+}
+
+bool RecordingStore::appendChord(const ChordEvent& event)
+{
+    if (chords_.size() == chords_.capacity())
+    {
+        ++numDroppedChords_;
+        return false;
+    }
+
+    chords_.push_back(event);
+    return true;
+}
+
+void RecordingStore::finish()
+{
+    if (spillStream_ != nullptr)
+        spillStream_->flush();
+}
+
+void RecordingStore::spillOldestChunk()
+{
+    if (spillStream_ == nullptr)
+    {
+        spillFile_ = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                         .getNonexistentChildFile("MonolithMaestroRecording", ".mmrec", false);
+        spillStream_ = std::make_unique<juce::FileOutputStream>(spillFile_);
+
+        // Without a spill file the oldest chunk simply stays resident (cap exceeded, nothing lost)
+        if (spillStream_->failedToOpen())
+        {
+            spillStream_.reset();
+            return;
+        }
+    }
+
+    auto oldest = std::move(chunks_.front());
+    chunks_.erase(chunks_.begin());
+
+    // 18 bytes per note: onset, duration, MIDI note, pitch deviation, velocities, source and a host-time
+    // flag (session id is implied); host time adds 32 bytes only when it is present
+    for (int i = 0; i < oldest->numEvents; ++i)
+    {
+        const auto& event = oldest->events[static_cast<size_t>(i)];
+        spillStream_->writeInt64(event.onsetSample);
+        spillStream_->writeInt((int) juce::jmin(event.getDuration(), (juce::int64) std::numeric_limits<int>::max()));
+        spillStream_->writeByte((char) event.midiNoteNumber);
+        spillStream_->writeByte((char) event.centsOffset);
+        spillStream_->writeByte((char) event.peakVelocity);
+        spillStream_->writeByte((char) event.meanVelocity);
+        spillStream_->writeByte((char) event.sourceChannel);
+        spillStream_->writeByte((char) (event.hasHostTime ? 1 : 0));
+
+        if (event.hasHostTime)
+        {
+            spillStream_->writeDouble(event.onsetPpq);
+            spillStream_->writeDouble(event.offsetPpq);
+            spillStream_->writeDouble(event.onsetSeconds);
+            spillStream_->writeFloat(event.bpm);
+            spillStream_->writeInt(event.bar);
+        }
+    }
+
+    numSpilledEvents_ += oldest->numEvents;
+    numResidentEvents_ -= oldest->numEvents;
+    pool_->release(std::move(oldest));
+}
+
+//==============================================================================
+void RecordingStore::forEachEvent(const std::function<void(const NoteEvent&)>& visitor) const
+{
+    if (numSpilledEvents_ > 0)
+    {
+        juce::FileInputStream input(spillFile_);
+
+        if (input.openedOk())
+        {
+            NoteEvent event;
+            event.sessionId = sessionId_;
+
+            for (juce::int64 i = 0; i < numSpilledEvents_; ++i)
+            {
+                event.onsetSample = input.readInt64();
+                event.offsetSample = event.onsetSample + input.readInt();
+                event.midiNoteNumber = (juce::int8) input.readByte();
+                event.centsOffset = (juce::int8) input.readByte();
+                event.peakVelocity = (juce::uint8) input.readByte();
+                event.meanVelocity = (juce::uint8) input.readByte();
+                event.sourceChannel = (juce::int8) input.readByte();
+                event.hasHostTime = input.readByte() != 0;
+
+                if (event.hasHostTime)
+                {
+                    event.onsetPpq = input.readDouble();
+                    event.offsetPpq = input.readDouble();
+                    event.onsetSeconds = input.readDouble();
+                    event.bpm = input.readFloat();
+                    event.bar = input.readInt();
+                }
+                visitor(event);
+            }
+        }
+    }
+
+    for (const auto& chunk : chunks_)
+        for (int i = 0; i < chunk->numEvents; ++i)
+            visitor(chunk->events[static_cast<size_t>(i)]);
+}
+
+void RecordingStore::forEachRecentEvent(int maxEvents, const std::function<void(const NoteEvent&)>& visitor) const
+{
+    auto toSkip = juce::jmax((juce::int64) 0, numResidentEvents_ - maxEvents);
+
+    for (const auto& chunk : chunks_)
+    {
+        const auto first = (int) juce::jmin(toSkip, (juce::int64) chunk->numEvents);
+        toSkip -= first;
+
+        for (int i = first; i < chunk->numEvents; ++i)
+            visitor(chunk->events[static_cast<size_t>(i)]);
+    }
+}
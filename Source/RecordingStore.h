@@ -0,0 +1,189 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "ChordEvent.h"
+#include "NoteEvent.h"
+#include <array>
+#include <functional>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/** A stretch of a recording that stays in one key. */
+struct KeyRegion
+{
+    juce::int64 startSample = 0;        ///< Onset of the region's first note (samples since the recording started)
+    juce::int64 endSample = 0;          ///< End of its last note
+    double startPpq = 0.0;              ///< Host timeline start in quarter notes (if hasHostTime)
+    juce::int32 startBar = 0;           ///< Host bar of the start (if hasHostTime)
+    juce::int64 numNotes = 0;           ///< Notes in the region
+    int key = -1;                       ///< 0-11 = C..B major, 12-23 = C..B minor
+    float confidence = 0.0f;            ///< Correlation of the region's notes with the key profile
+    bool hasHostTime = false;           ///< The first note had host timeline fields
+};
+
+//==============================================================================
+/**
+ * Append-only store for one recording session with bounded memory.
+ *
+ * Events are kept in fixed-size chunks drawn from a shared ChunkPool. Once more
+ * than the configured number of chunks are resident, the oldest full chunk is
+ * written to a compact binary spill file and its memory goes back to the pool,
+ * so hours-long sessions stay within the cap. Appending (and therefore
+ * spilling) happens on the recorder's background thread.
+ *
+ * Only finished notes are stored, one record each, in onset order; the
+ * recorder holds notes back until that order is certain. Chord changes
+ * are far sparser than notes and go in a list reserved up front, so
+ * appending one never allocates; changes beyond its capacity are counted
+ * and dropped.
+ */
+class RecordingStore
+{
+public:
+    //==============================================================================
+    static constexpr int eventsPerChunk = 512;                ///< Events per fixed-size chunk
+
+    /** Fixed-size block of events. */
+    struct Chunk
+    {
+        std::array<NoteEvent, eventsPerChunk> events;
+        int numEvents = 0;
+    };
+
+    //==============================================================================
+    /**
+     * Recycles chunks between sessions so steady-state recording never
+     * returns memory to (or requests it from) the system allocator.
+     */
+    class ChunkPool
+    {
+    public:
+        /** Makes sure at least numChunks free chunks are available. */
+        void reserve(int numChunks);
+
+        /** Takes a chunk from the pool, allocating only if the pool is empty. */
+        std::unique_ptr<Chunk> acquire();
+
+        /** Returns a chunk to the pool. */
+        void release(std::unique_ptr<Chunk> chunk);
+
+        /** Gets the number of chunks waiting in the pool. */
+        int getNumFreeChunks() const;
+
+    private:
+        juce::CriticalSection lock_;                          ///< Guards freeChunks_
+        std::vector<std::unique_ptr<Chunk>> freeChunks_;      ///< Recycled chunks
+    };
+
+    //==============================================================================
+    /**
+     * Creates an empty store.
+     *
+     * @param pool Pool to draw chunks from (shared so the store may outlive its recorder)
+     * @param maxResidentChunks Chunks kept in memory before the oldest are spilled
+     * @param maxChords Chord changes the store can hold
+     */
+    RecordingStore(std::shared_ptr<ChunkPool> pool, int maxResidentChunks, int maxChords = 0);
+    ~RecordingStore();
+
+    //==============================================================================
+    /**
+     * Appends a finished note, spilling the oldest chunk if the memory cap is
+     * exceeded. Notes must arrive in onset order.
+     */
+    void append(const NoteEvent& event);
+
+    /**
+     * Appends a chord change (recorder thread). Never allocates.
+     *
+     * @return false if the store was full and the change was dropped
+     */
+    bool appendChord(const ChordEvent& event);
+
+    /** Flushes pending spill data so readers see every event. */
+    void finish();
+
+    /**
+     * Visits every event in time order, reading spilled chunks back from disk.
+     * Must not run concurrently with append().
+     */
+    void forEachEvent(const std::function<void(const NoteEvent&)>& visitor) const;
+
+    /**
+     * Visits the latest events in time order without touching the spill file.
+     * Only resident events are visited, so fewer than maxEvents may be seen
+     * once the session has spilled more than a chunk's worth.
+     * Must not run concurrently with append().
+     */
+    void forEachRecentEvent(int maxEvents, const std::function<void(const NoteEvent&)>& visitor) const;
+
+    //==============================================================================
+    /** Gets the total number of events (resident and spilled). */
+    juce::int64 getNumEvents() const { return numSpilledEvents_ + numResidentEvents_; }
+
+    /** Gets the number of events written to the spill file. */
+    juce::int64 getNumSpilledEvents() const { return numSpilledEvents_; }
+
+    /** Gets the memory held by resident chunks in bytes. */
+    size_t getResidentBytes() const { return chunks_.size() * sizeof(Chunk); }
+
+    /** Gets the memory cap in chunks. */
+    int getMaxResidentChunks() const { return maxResidentChunks_; }
+
+    /** Gets the spill file (may not exist if nothing was spilled). */
+    const juce::File& getSpillFile() const { return spillFile_; }
+
+    /** Takes ownership of the MIDI file streamed alongside the session (deleted with the store). */
+    void setMidiFile(const juce::File& file) { midiFile_ = file; }
+
+    /** Gets the session's Standard MIDI File (may not exist if it could not be written). */
+    const juce::File& getMidiFile() const { return midiFile_; }
+
+    /** Gets the session's chord changes in time order. */
+    const std::vector<ChordEvent>& getChords() const { return chords_; }
+
+    /** Gets the number of chord changes dropped because the store was full. */
+    int getNumDroppedChords() const { return numDroppedChords_; }
+
+    /** Stores the key of the whole session (set once the recording is finished). */
+    void setKey(int key, float confidence) { key_ = key; keyConfidence_ = confidence; }
+
+    /** Gets the key of the whole session: 0-11 = C..B major, 12-23 = C..B minor, -1 = not analysed or no notes. */
+    int getKey() const { return key_; }
+
+    /** Gets how well the session's notes fit its key. */
+    float getKeyConfidence() const { return keyConfidence_; }
+
+    /** Stores the session's key regions (set once the recording is finished). */
+    void setKeyRegions(std::vector<KeyRegion> regions) { keyRegions_ = std::move(regions); }
+
+    /** Gets the session's key regions in time order (empty if not analysed). */
+    const std::vector<KeyRegion>& getKeyRegions() const { return keyRegions_; }
+
+private:
+    //==============================================================================
+    /** Writes the oldest resident chunk to the spill file and recycles it. */
+    void spillOldestChunk();
+
+    std::shared_ptr<ChunkPool> pool_;                         ///< Chunk source
+    const int maxResidentChunks_;                             ///< Memory cap in chunks
+    std::vector<std::unique_ptr<Chunk>> chunks_;              ///< Resident chunks, oldest first
+    juce::int64 numResidentEvents_ = 0;                       ///< Events in chunks_
+
+    juce::File spillFile_;                                    ///< Compact binary overflow
+    std::unique_ptr<juce::FileOutputStream> spillStream_;     ///< Open while spilling
+    juce::int64 numSpilledEvents_ = 0;                        ///< Events in spillFile_
+    juce::uint32 sessionId_ = 0;                              ///< Restored on read-back
+    juce::File midiFile_;                                     ///< Streamed SMF export
+    int key_ = -1;                                            ///< Key of the whole session
+    float keyConfidence_ = 0.0f;                              ///< Correlation of its notes with the key profile
+    std::vector<KeyRegion> keyRegions_;                       ///< Key modulation timeline
+    std::vector<ChordEvent> chords_;                          ///< Chord changes (capacity reserved up front)
+    int numDroppedChords_ = 0;                                ///< Changes that found chords_ full
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RecordingStore)
+};
+
+/** Lightweight, shareable reference to a finished recording. */
+using RecordingHandle = std::shared_ptr<const RecordingStore>;
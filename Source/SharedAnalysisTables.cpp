@@ -0,0 +1,220 @@
+#include "SharedAnalysisTables.h"
+#include <array>
+#include <map>
+#include <tuple>
+
+namespace
+{
+    struct TableKey
+    {
+        int fftOrder;
+        SharedAnalysisTables::WindowType windowType;
+        double sampleRate;
+
+        bool operator<(const TableKey& other) const
+        {
+            return std::tie(fftOrder, windowType, sampleRate)
+                 < std::tie(other.fftOrder, other.windowType, other.sampleRate);
+        }
+    };
+
+    /** Process-wide cache. Entries expire when the last instance releases its tables. */
+    struct TableCache
+    {
+        juce::CriticalSection lock;
+        std::map<TableKey, std::weak_ptr<const SharedAnalysisTables>> entries;
+    };
+
+    TableCache& getTableCache()
+    {
+        static TableCache cache;
+        return cache;
+    }
+}
+
+//==============================================================================
+std::shared_ptr<const SharedAnalysisTables> SharedAnalysisTables::acquire(int fftOrder, WindowType windowType,
+                                                                          double sampleRate)
+{
+    auto& cache = getTableCache();
+    const juce::ScopedLock lock(cache.lock);
+
+    const TableKey key { fftOrder, windowType, sampleRate };
+    const auto existing = cache.entries.find(key);
+
+    if (existing != cache.entries.end())
+        if (auto tables = existing->second.lock())
+            return tables;
+
+    // Drop entries whose last user has gone
+    for (auto it = cache.entries.begin(); it != cache.entries.end();)
+        it = it->second.expired() ? cache.entries.erase(it) : std::next(it);
+
+    auto tables = std::make_shared<const SharedAnalysisTables>(fftOrder, windowType, sampleRate);
+    cache.entries[key] = tables;
+    return tables;
+}
+
+int SharedAnalysisTables::getNumLiveTables()
+{
+    auto& cache = getTableCache();
+    const juce::ScopedLock lock(cache.lock);
+
+    return static_cast<int>(std::count_if(cache.entries.begin(), cache.entries.end(),
+        [](const auto& entry) { return !entry.second.expired(); }));
+}
+
+//==============================================================================
+SharedAnalysisTables::SharedAnalysisTables(int fftOrder, WindowType windowType, double sampleRate)
+    : fftSize_(1 << fftOrder)
+    , sampleRate_(sampleRate)
+{
+    if (fftOrder == CompileTimeTables::fftOrder)
+    {
+        window_ = windowType == WindowType::blackmanHarris ? CompileTimeTables::blackmanHarrisWindow.data()
+                                                           : CompileTimeTables::hannWindow.data();
+        twiddles_ = CompileTimeTables::twiddles.data();
+    }
+    else
+    {
+        computeRuntimeTables(windowType);
+    }
+
+    initializeBinIndex();
+    initializeChromaWeights();
+}
+
+void SharedAnalysisTables::computeRuntimeTables(WindowType windowType)
+{
+    runtimeWindow_.resize(static_cast<size_t>(fftSize_));
+    const float denominator = fftSize_ - 1.0f;
+
+    for (int i = 0; i < fftSize_; ++i)
+    {
+        const float phase = 2.0f * juce::MathConstants<float>::pi * i / denominator;
+
+        if (windowType == WindowType::blackmanHarris)
+        {
+            runtimeWindow_[static_cast<size_t>(i)] = 0.35875f - 0.48829f * std::cos(phase)
+                                                   + 0.14128f * std::cos(2.0f * phase) - 0.01168f * std::cos(3.0f * phase);
+        }
+        else
+        {
+            // Hann window: w(n) = 0.5 * (1 - cos(2π * n / (N-1)))
+            runtimeWindow_[static_cast<size_t>(i)] = 0.5f * (1.0f - std::cos(phase));
+        }
+    }
+
+    // Butterfly twiddles for recombining the decimated sub-transforms
+    runtimeTwiddles_.resize(static_cast<size_t>(fftSize_));
+    for (int k = 0; k < fftSize_ / 2; ++k)
+    {
+        const double angle = -2.0 * juce::MathConstants<double>::pi * k / fftSize_;
+        runtimeTwiddles_[static_cast<size_t>(2 * k)] = static_cast<float>(std::cos(angle));
+        runtimeTwiddles_[static_cast<size_t>(2 * k + 1)] = static_cast<float>(std::sin(angle));
+    }
+
+    window_ = runtimeWindow_.data();
+    twiddles_ = runtimeTwiddles_.data();
+}
+
+void SharedAnalysisTables::initializeBinIndex()
+{
+    // For each bin, the first range a frequency rounding to that bin can belong to
+    // (a full bin below rather than half, to stay safe against rounding)
+    const double hzPerBin = sampleRate_ / fftSize_;
+    firstNoteForBin_.resize(static_cast<size_t>(fftSize_ / 2 + 1));
+
+    int note = 0;
+    for (size_t bin = 0; bin < firstNoteForBin_.size(); ++bin)
+    {
+        const double lowestFrequency = (static_cast<double>(bin) - 1.0) * hzPerBin;
+
+        while (note < numMappedNotes_ && frequencyMap_[note].maxFrequency <= lowestFrequency)
+            ++note;
+
+        firstNoteForBin_[bin] = static_cast<juce::int16>(note);
+    }
+}
+
+void SharedAnalysisTables::initializeChromaWeights()
+{
+    const double hzPerBin = sampleRate_ / fftSize_;
+    const double highestFrequency = juce::jmin(sampleRate_ * 0.5, CompileTimeTables::midiNoteToFrequency(108));
+
+    const int firstBin = juce::jmax(1, static_cast<int>(std::ceil(lowestChromaFrequency_ / hzPerBin)));
+    const int lastBin = juce::jmin(fftSize_ / 2 - 1, static_cast<int>(highestFrequency / hzPerBin));
+
+    const auto toMidiNote = [](double frequency) { return 69.0 + 12.0 * std::log2(frequency / 440.0); };
+
+    chromaWeights_.clear();
+    chromaWeights_.reserve(static_cast<size_t>(juce::jmax(0, 2 * (lastBin - firstBin + 1))));
+
+    for (int bin = firstBin; bin <= lastBin; ++bin)
+    {
+        // A bin spanning less than a semitone is shared between the notes either side of its centre
+        const double lowestNote = toMidiNote((bin - 0.5) * hzPerBin);
+        const double highestNote = toMidiNote((bin + 0.5) * hzPerBin);
+
+        if (highestNote - lowestNote <= 1.0)
+        {
+            const double midiNote = toMidiNote(bin * hzPerBin);
+            const int lowerNote = static_cast<int>(std::floor(midiNote));
+            const auto upperShare = static_cast<float>(midiNote - lowerNote);
+
+            if (upperShare < 1.0f)
+                chromaWeights_.push_back({ static_cast<juce::int16>(bin), static_cast<juce::int16>(lowerNote % 12), 1.0f - upperShare });
+
+            if (upperShare > 0.0f)
+                chromaWeights_.push_back({ static_cast<juce::int16>(bin), static_cast<juce::int16>((lowerNote + 1) % 12), upperShare });
+
+            continue;
+        }
+
+        // A wider bass bin is spread over every semitone it covers, by how much of its span each one takes
+        std::array<float, 12> shares {};
+        for (int note = static_cast<int>(std::floor(lowestNote + 0.5)); note - 0.5 < highestNote; ++note)
+        {
+            const double overlap = juce::jmin(highestNote, note + 0.5) - juce::jmax(lowestNote, note - 0.5);
+            shares[static_cast<size_t>(note % 12)] += static_cast<float>(overlap / (highestNote - lowestNote));
+        }
+
+        for (int pitchClass = 0; pitchClass < 12; ++pitchClass)
+            if (shares[static_cast<size_t>(pitchClass)] > 0.0f)
+                chromaWeights_.push_back({ static_cast<juce::int16>(bin), static_cast<juce::int16>(pitchClass),
+                                           shares[static_cast<size_t>(pitchClass)] });
+    }
+}
+
+const SharedAnalysisTables::NoteFrequencyRange* SharedAnalysisTables::findNoteForFrequency(float frequency) const
+{
+    if (!(frequency > 0.0f))
+        return nullptr;
+
+    // Jump to the ranges around the nearest bin instead of scanning the whole map
+    const auto hzPerBin = static_cast<float>(sampleRate_ / fftSize_);
+    const auto bin = juce::jmin(static_cast<int>(firstNoteForBin_.size()) - 1,
+                                static_cast<int>(frequency / hzPerBin + 0.5f));
+
+    for (int i = firstNoteForBin_[static_cast<size_t>(bin)]; i < numMappedNotes_; ++i)
+    {
+        const auto& range = frequencyMap_[i];
+
+        if (frequency < range.minFrequency)
+            break;
+
+        if (frequency < range.maxFrequency)
+            return &range;
+    }
+
+    return nullptr;  // Frequency out of range
+}
+
+size_t SharedAnalysisTables::getMemoryFootprintBytes() const
+{
+    return sizeof(*this)
+         + firstNoteForBin_.capacity() * sizeof(juce::int16)
+         + chromaWeights_.capacity() * sizeof(ChromaWeight)
+         + runtimeWindow_.capacity() * sizeof(float)
+         + runtimeTwiddles_.capacity() * sizeof(float);
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include "CompileTimeTables.h"
+#include <complex>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/**
+ * Immutable lookup tables shared by every PitchDetector in the process.
+ *
+ * Holds the analysis window and butterfly twiddles, the frequency-to-note
+ * map, a per-bin index into that map and the sparse bin-to-pitch-class
+ * (chroma) matrix. Tables are built
+ * once per (FFT order, window type, sample rate) and reference counted, so
+ * instances on many tracks share a single copy. For the built-in frame size the
+ * window, twiddles and note map point at CompileTimeTables; only the
+ * sample-rate dependent bin index and chroma matrix are built at runtime.
+ *
+ * Everything here is read-only, so detectors on any number of threads can use
+ * it at once. The FFT engine is deliberately not shared: not every JUCE FFT
+ * engine is safe to run from two threads (IPP's perform() goes through a work
+ * buffer inside the engine), so each detector owns its own.
+ */
+class SharedAnalysisTables
+{
+public:
+    //==============================================================================
+    /** Analysis window shapes. */
+    enum class WindowType
+    {
+        hann,           ///< Hann window (default)
+        blackmanHarris  ///< 4-term Blackman-Harris (lower sidelobes, wider main lobe)
+    };
+
+    /** Frequency range mapping for a musical note. */
+    using NoteFrequencyRange = CompileTimeTables::NoteFrequencyRange;
+
+    /** One non-zero entry of the bin-to-pitch-class matrix. */
+    struct ChromaWeight
+    {
+        juce::int16 bin;                ///< Magnitude bin
+        juce::int16 pitchClass;         ///< 0-11, C = 0
+        float weight;                   ///< Share of the bin's magnitude given to the pitch class
+    };
+
+    //==============================================================================
+    /**
+     * Gets the shared tables for a configuration, building them if no instance
+     * currently holds them. Not real-time safe.
+     *
+     * @param fftOrder   log2 of the analysis frame size
+     * @param windowType Analysis window shape
+     * @param sampleRate Audio sample rate in Hz
+     * @return Tables kept alive for as long as the pointer is held
+     */
+    static std::shared_ptr<const SharedAnalysisTables> acquire(int fftOrder, WindowType windowType, double sampleRate);
+
+    /** Gets the number of distinct table sets currently alive in the process. */
+    static int getNumLiveTables();
+
+    //==============================================================================
+    /** Gets the window coefficients (getFFTSize() values). */
+    const float* getWindow() const { return window_; }
+
+    /** Gets exp(-2πik / N) for k < N / 2. */
+    const std::complex<float>* getTwiddles() const { return reinterpret_cast<const std::complex<float>*>(twiddles_); }
+
+    /** Gets the analysis frame size. */
+    int getFFTSize() const { return fftSize_; }
+
+    /**
+     * Finds which note a frequency belongs to.
+     *
+     * @param frequency Frequency in Hz
+     * @return Pointer to NoteFrequencyRange or nullptr if out of range
+     */
+    const NoteFrequencyRange* findNoteForFrequency(float frequency) const;
+
+    /**
+     * Gets the non-zero entries of the bin-to-pitch-class matrix, in bin order.
+     * Each bin from 40 Hz to C8 spanning less than a semitone is split between
+     * the two nearest pitch classes in proportion to how close it is to each;
+     * a wider bass bin is spread over every semitone it covers.
+     */
+    const ChromaWeight* getChromaWeights() const { return chromaWeights_.data(); }
+
+    /** Gets the number of entries returned by getChromaWeights(). */
+    int getNumChromaWeights() const { return static_cast<int>(chromaWeights_.size()); }
+
+    /** Gets the heap memory held by these tables. */
+    size_t getMemoryFootprintBytes() const;
+
+    //==============================================================================
+    static constexpr int numMappedNotes_ = CompileTimeTables::numMappedNotes;
+
+    /** Builds a table set. Use acquire() to share them instead. */
+    SharedAnalysisTables(int fftOrder, WindowType windowType, double sampleRate);
+
+private:
+    //==============================================================================
+    /** Computes window and twiddles for frame sizes without compile-time tables. */
+    void computeRuntimeTables(WindowType windowType);
+
+    /** Builds the per-bin index into the frequency map. */
+    void initializeBinIndex();
+
+    /** Builds the sparse bin-to-pitch-class matrix. */
+    void initializeChromaWeights();
+
+    static constexpr double lowestChromaFrequency_ = 40.0;    ///< Chroma floor in Hz (bottom of the bass register)
+
+    const int fftSize_;                                       ///< Analysis frame size
+    const double sampleRate_;                                 ///< Sample rate the bin index was built for
+    const float* window_ = nullptr;                           ///< Window coefficients
+    const float* twiddles_ = nullptr;                         ///< Butterfly twiddles as interleaved (real, imag)
+    const NoteFrequencyRange* frequencyMap_ = CompileTimeTables::frequencyMap.data();  ///< C1 to C7, ascending
+    std::vector<juce::int16> firstNoteForBin_;                ///< First map entry a frequency near each bin can fall in
+    std::vector<ChromaWeight> chromaWeights_;                 ///< Sparse chroma matrix, in bin order
+    std::vector<float> runtimeWindow_;                        ///< Storage for non-built-in frame sizes only
+    std::vector<float> runtimeTwiddles_;                      ///< Storage for non-built-in frame sizes only
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedAnalysisTables)
+};
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <utility>
+
+//==============================================================================
+/**
+ * Running median of the last windowSize values, updated in O(log n).
+ *
+ * The window is split into two binary heaps sharing one index array: a
+ * max-heap of the lower half (root at 0) and a min-heap of the upper half
+ * (root at lowerSize). Every value keeps its heap position, so the oldest
+ * value can be overwritten in place and sifted rather than searched for, and
+ * after one update at most the two roots can be out of order. The median is
+ * the lower root.
+ *
+ * Trivially copyable with no pointers, so arrays of these can live in a
+ * DetectorArena. The window is always full: fill() seeds every slot.
+ */
+template <int windowSize>
+class SlidingMedian
+{
+public:
+    static_assert(windowSize % 2 == 1 && windowSize < 32768, "Odd window sizes only, so the median is one value");
+
+    //==============================================================================
+    /** Sets every value in the window. */
+    void fill(float value)
+    {
+        for (int slot = 0; slot < windowSize; ++slot)
+        {
+            values_[static_cast<size_t>(slot)] = value;
+            heap_[static_cast<size_t>(slot)] = static_cast<juce::int16>(slot);
+            heapIndex_[static_cast<size_t>(slot)] = static_cast<juce::int16>(slot);
+        }
+
+        oldest_ = 0;
+    }
+
+    /** Replaces the oldest value in the window. */
+    void push(float value)
+    {
+        const int slot = oldest_;
+        oldest_ = static_cast<juce::int16>(slot + 1 == windowSize ? 0 : slot + 1);
+        values_[static_cast<size_t>(slot)] = value;
+
+        siftDown(siftUp(heapIndex_[static_cast<size_t>(slot)]));
+
+        // Only the replaced value can be on the wrong side; swapping the roots fixes it
+        if (windowSize > 1 && getValue(0) > getValue(lowerSize))
+        {
+            swapPositions(0, lowerSize);
+            siftDown(0);
+            siftDown(lowerSize);
+        }
+    }
+
+    /** Gets the median of the window. */
+    float getMedian() const { return getValue(0); }
+
+private:
+    //==============================================================================
+    static constexpr int lowerSize = (windowSize + 1) / 2;    ///< Lower half, including the median
+
+    float getValue(int position) const { return values_[static_cast<size_t>(heap_[static_cast<size_t>(position)])]; }
+
+    static bool isLower(int position) { return position < lowerSize; }
+
+    /** Checks if the value at position a belongs above the one at b in their (shared) heap. */
+    bool outranks(int a, int b) const
+    {
+        return isLower(a) ? getValue(a) > getValue(b) : getValue(a) < getValue(b);
+    }
+
+    static int getParent(int position)
+    {
+        return isLower(position) ? (position - 1) / 2 : lowerSize + (position - lowerSize - 1) / 2;
+    }
+
+    static int getFirstChild(int position)
+    {
+        return isLower(position) ? 2 * position + 1 : lowerSize + 2 * (position - lowerSize) + 1;
+    }
+
+    static bool isRoot(int position) { return position == 0 || position == lowerSize; }
+
+    static int getEnd(int position) { return isLower(position) ? lowerSize : windowSize; }
+
+    void swapPositions(int a, int b)
+    {
+        std::swap(heap_[static_cast<size_t>(a)], heap_[static_cast<size_t>(b)]);
+        heapIndex_[static_cast<size_t>(heap_[static_cast<size_t>(a)])] = static_cast<juce::int16>(a);
+        heapIndex_[static_cast<size_t>(heap_[static_cast<size_t>(b)])] = static_cast<juce::int16>(b);
+    }
+
+    /** Moves a value towards its heap's root while it outranks its parent. */
+    int siftUp(int position)
+    {
+        while (!isRoot(position))
+        {
+            const int parent = getParent(position);
+            if (!outranks(position, parent))
+                break;
+
+            swapPositions(position, parent);
+            position = parent;
+        }
+
+        return position;
+    }
+
+    /** Moves a value away from its heap's root while a child outranks it. */
+    void siftDown(int position)
+    {
+        const int end = getEnd(position);
+
+        for (int child = getFirstChild(position); child < end; child = getFirstChild(position))
+        {
+            if (child + 1 < end && outranks(child + 1, child))
+                ++child;
+
+            if (!outranks(child, position))
+                break;
+
+            swapPositions(position, child);
+            position = child;
+        }
+    }
+
+    std::array<float, windowSize> values_ {};                 ///< Window contents, by slot
+    std::array<juce::int16, windowSize> heap_ {};             ///< Slot at each heap position
+    std::array<juce::int16, windowSize> heapIndex_ {};        ///< Heap position of each slot
+    juce::int16 oldest_ = 0;                                  ///< Slot push() replaces next
+};
@@ -0,0 +1,112 @@
+#include "StringDetectorBank.h"
+#include "CompileTimeTables.h"
+#include <cmath>
+
+//==============================================================================
+void StringDetectorBank::setTuning(const std::vector<int>& openStringNotes)
+{
+    tuningSize_ = juce::jmin(static_cast<int>(openStringNotes.size()), maxStrings);
+
+    for (int string = 0; string < tuningSize_; ++string)
+        tuning_[static_cast<size_t>(string)] = juce::jlimit(0, 127, openStringNotes[static_cast<size_t>(string)]);
+}
+
+void StringDetectorBank::prepare(double sampleRate, int expectedBlockSize, int numStrings)
+{
+    numStrings_ = numStrings >= minStrings ? juce::jmin(numStrings, maxStrings) : 0;
+
+    for (int string = 0; string < numStrings_; ++string)
+    {
+        const int openNote = string < tuningSize_ ? tuning_[static_cast<size_t>(string)]
+                                                  : getStandardOpenNote(numStrings_, string);
+
+        // Out to the boundaries with the neighbouring notes, for bends and tuning drift
+        const int lowestNote = openNote - semitonesBelowOpen_;
+        const int highestNote = openNote + semitonesAboveOpen_;
+
+        auto& detector = detectors_[static_cast<size_t>(string)];
+        detector.setFrequencyRange(getNoteBoundary(lowestNote - 1), getNoteBoundary(highestNote));
+        detector.setSourceChannel(string);
+        detector.setBatchedTransformEnabled(true);
+        detector.prepare(sampleRate, expectedBlockSize);
+    }
+
+    batchedFFT_.prepare(PitchDetector::getFFTOrder(), detectors_[0].getWindowType(), sampleRate, numStrings_);
+
+    for (int string = 0; string < numStrings_; ++string)
+    {
+        const auto& detector = detectors_[static_cast<size_t>(string)];
+        batchedFFT_.setSearchRange(string, detector.getLowestSearchedBin(), detector.getHighestSearchedBin());
+    }
+}
+
+void StringDetectorBank::processBlock(const float* const* strings, int numSamples, const float* referenceData)
+{
+    // No more than a frame at a time, so each detector completes at most one frame per pass
+    for (int done = 0; done < numSamples;)
+    {
+        const int length = juce::jmin(numSamples - done, PitchDetector::getFFTSize());
+        std::array<const float*, maxStrings> frames {};
+        bool anyFrame = false;
+
+        for (int string = 0; string < numStrings_; ++string)
+        {
+            auto& detector = detectors_[static_cast<size_t>(string)];
+            detector.processAudioBlock(strings[string] + done, length,
+                                       referenceData != nullptr ? referenceData + done : nullptr);
+
+            frames[static_cast<size_t>(string)] = detector.getBatchFrame();
+            anyFrame = anyFrame || frames[static_cast<size_t>(string)] != nullptr;
+        }
+
+        if (anyFrame)
+        {
+            batchedFFT_.perform(frames.data());
+
+            for (int string = 0; string < numStrings_; ++string)
+            {
+                if (frames[static_cast<size_t>(string)] != nullptr)
+                    detectors_[static_cast<size_t>(string)].completeBatchFrame(batchedFFT_.getMagnitudes() + string,
+                                                                              batchedFFT_.getNumLanes(),
+                                                                              batchedFFT_.getStrongestBin(string),
+                                                                              batchedFFT_.getStrongestMagnitude(string));
+            }
+        }
+
+        done += length;
+    }
+}
+
+std::vector<DetectedNote> StringDetectorBank::getDetectedNotes() const
+{
+    std::vector<DetectedNote> notes;
+
+    // Monophonic per string: at most one note each
+    for (int string = 0; string < numStrings_; ++string)
+    {
+        const auto stringNotes = detectors_[static_cast<size_t>(string)].getDetectedNotes();
+        notes.insert(notes.end(), stringNotes.begin(), stringNotes.end());
+    }
+
+    return notes;
+}
+
+float StringDetectorBank::getNoteBoundary(int midiNote)
+{
+    // Geometric midpoint, as in the note map
+    return static_cast<float>(std::sqrt(CompileTimeTables::midiNoteToFrequency(midiNote)
+                                        * CompileTimeTables::midiNoteToFrequency(midiNote + 1)));
+}
+
+int StringDetectorBank::getStandardOpenNote(int numStrings, int string)
+{
+    // Lowest string first: B0 E1 A1 D2 G2 for bass, F#1 B1 E2 A2 D3 G3 B3 E4 for guitar
+    static constexpr std::array<int, 5> bass { 23, 28, 33, 38, 43 };
+    static constexpr std::array<int, 8> guitar { 30, 35, 40, 45, 50, 55, 59, 64 };
+
+    // Four and five strings take the top of the bass table, six to eight the top of the guitar one
+    if (numStrings <= static_cast<int>(bass.size()))
+        return bass[static_cast<size_t>(juce::jlimit(0, 4, static_cast<int>(bass.size()) - numStrings + string))];
+
+    return guitar[static_cast<size_t>(juce::jlimit(0, 7, static_cast<int>(guitar.size()) - numStrings + string))];
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "BatchedFFT.h"
+#include "PitchDetector.h"
+#include <array>
+#include <vector>
+
+//==============================================================================
+/**
+ * One monophonic pitch detector per string of a divided (hexaphonic) pickup.
+ *
+ * Each string arrives on its own channel, lowest string first, and its
+ * detector only searches the range that string can play: from a whole tone
+ * below its open note (drop tunings) to its 24th fret. Crosstalk from the
+ * neighbouring strings and the string's own upper partials then can't be
+ * picked, which makes per-string detection far more reliable than
+ * polyphonic detection on the summed signal.
+ *
+ * The detectors are fed the same blocks in one pass, so their frames
+ * complete, and their results are published, in the same callbacks. Frames
+ * completing together are transformed as one batch, a string per SIMD lane;
+ * only the transform is shared, and each detector spreads the rest of its
+ * analysis over the following callbacks as usual. With the reference input
+ * enabled each detector transforms its own frames as usual.
+ */
+class StringDetectorBank
+{
+public:
+    //==============================================================================
+    static constexpr int minStrings = 4;          ///< Four-string bass
+    static constexpr int maxStrings = 8;          ///< Eight-string guitar
+
+    StringDetectorBank() = default;
+    ~StringDetectorBank() = default;
+
+    /**
+     * Sets the open-string notes, lowest string first. Strings beyond the
+     * tuning (or every string, with an empty tuning) use the standard tuning
+     * for the string count. Takes effect on the next prepare().
+     *
+     * @param openStringNotes MIDI note of each open string
+     */
+    void setTuning(const std::vector<int>& openStringNotes);
+
+    /**
+     * Prepares a detector per string. Not real-time safe.
+     *
+     * @param sampleRate        Audio sample rate in Hz
+     * @param expectedBlockSize Maximum samples per audio block
+     * @param numStrings        Strings to analyse (0 for none, otherwise minStrings to maxStrings)
+     */
+    void prepare(double sampleRate, int expectedBlockSize, int numStrings);
+
+    /** Gets the number of strings analysed since the last prepare() (0 when unused). */
+    int getNumStrings() const { return numStrings_; }
+
+    /**
+     * Analyses a block of every string (audio thread).
+     *
+     * @param strings       One mono channel per string, lowest string first
+     * @param numSamples    Number of samples in each channel
+     * @param referenceData Accompaniment reference for the block, or nullptr
+     */
+    void processBlock(const float* const* strings, int numSamples, const float* referenceData);
+
+    /**
+     * Gets the latest result of one string (audio thread). Its sourceChannel is the string index.
+     *
+     * @param string String index (0 = lowest)
+     */
+    const PitchDetector::FrameResult& getStringFrame(int string) const { return detectors_[static_cast<size_t>(string)].getLatestFrame(); }
+
+    /**
+     * Gets the detector of one string, to follow its frames (audio thread).
+     *
+     * @param string String index (0 = lowest)
+     */
+    const PitchDetector& getStringDetector(int string) const { return detectors_[static_cast<size_t>(string)]; }
+
+    /**
+     * Gets the notes detected on every string, lowest string first, each
+     * tagged with its string index as the channel.
+     */
+    std::vector<DetectedNote> getDetectedNotes() const;
+
+    /** Applies a setting to every string's detector (including unused ones). */
+    template <typename Setter>
+    void forEachDetector(Setter&& setter)
+    {
+        for (auto& detector : detectors_)
+            setter(detector);
+    }
+
+    /**
+     * Gets the standard tuning of a string.
+     *
+     * @param numStrings String count (minStrings to maxStrings): four and five are bass tunings
+     * @param string     String index (0 = lowest)
+     * @return MIDI note of the open string
+     */
+    static int getStandardOpenNote(int numStrings, int string);
+
+private:
+    //==============================================================================
+    /** Gets the frequency halfway (in pitch) between a note and the one above it. */
+    static float getNoteBoundary(int midiNote);
+
+    static constexpr int semitonesBelowOpen_ = 2;       ///< Lowest note searched, below the open string
+    static constexpr int semitonesAboveOpen_ = 24;      ///< Highest note searched (24th fret)
+
+    std::array<PitchDetector, maxStrings> detectors_;   ///< One per string
+    BatchedFFT batchedFFT_;                             ///< Transforms the strings' frames together
+    std::array<int, maxStrings> tuning_ {};             ///< Requested open notes (tuningSize_ of them)
+    int tuningSize_ = 0;                                ///< Strings with a requested open note
+    int numStrings_ = 0;                                ///< Strings analysed
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StringDetectorBank)
+};